@@ -34,6 +34,10 @@ void setup()
     //Additionnally, we can also wire a switch (active low)
     //if this pin is low during startup, the password will be reset
     //captivePortal.setSwitchPin(0);
+
+    //With several access points, the device can roam to a stronger one
+    //when the signal drops below -75 dBm (disabled by default)
+    //captivePortal.setRoaming(-75);
     
     //Start our captive portal (if not configured)
     //At first usage, you will find a new WiFi network named "MyThing"
@@ -33,6 +33,7 @@ ESPEasyCfgParameter<String> mqttServer("mqttServer", "MQTT server", "server.loca
 ESPEasyCfgParameter<String> mqttUser("mqttUser", "MQTT user", "user");
 ESPEasyCfgParameter<String> mqttPass("mqttPass", "MQTT password", "");
 ESPEasyCfgParameter<int> mqttPort("mqttPort", "MQTT port", 1883);
+ESPEasyCfgParameter<int> logLevel("logLevel", "Log level", 1, "Live setting, reset on boot");
 
 /**
  * Simple example of how to use the captive portal
@@ -48,9 +49,16 @@ void setup()
     mqttParamGrp.add(&mqttUser);
     mqttParamGrp.add(&mqttPass);
     mqttParamGrp.add(&mqttPort);
+    //The log level is tuned live with the Apply button, never written to flash
+    logLevel.setPersistence(ESPEasyCfgPersistence::Volatile);
+    mqttParamGrp.add(&logLevel);
     //Finally, add our parameter group to the captive portal
     captivePortal.addParameterGroup(&mqttParamGrp);
-    
+    //Parameters can also be set on the serial port, for example :
+    //SET mqttServer broker.local
+    //COMMIT
+    captivePortal.setSerialProvisioning(&Serial);
+
     //Start our captive portal (if not configured)
     //At first usage, you will find a new WiFi network named "MyThing"
     captivePortal.begin();
@@ -34,6 +34,18 @@ ESPEasyCfgParameter<String> mqttUser("mqttUser", "MQTT user", "user");
 ESPEasyCfgParameter<String> mqttPass("mqttPass", "MQTT password", "");
 ESPEasyCfgParameter<int> mqttPort("mqttPort", "MQTT port", 1883);
 
+/**
+ * Informations shown on the configuration page
+ * The firmware version never changes, the free heap is refreshed
+ * at most every 2 seconds.
+ */
+ESPEasyCfgInfo firmwareInfo("Firmware version", [](char* value, size_t size){
+  strlcpy(value, "1.0.0", size);
+});
+ESPEasyCfgInfo heapInfo("Free heap", [](char* value, size_t size){
+  snprintf(value, size, "%u bytes", (unsigned int)ESP.getFreeHeap());
+}, ESPEasyCfgInfoRefresh::TTL, 2000);
+
 /**
  * Shows actual MQTT parameters
  */
@@ -91,6 +103,9 @@ void setup()
     mqttParamGrp.add(&mqttPort);
     //Finally, add our parameter group to the captive portal
     captivePortal.addParameterGroup(&mqttParamGrp);
+    //Add our informations to the device informations
+    captivePortal.addInfo(&firmwareInfo);
+    captivePortal.addInfo(&heapInfo);
 
     //Register the callback to be notified when the captive portal
     //state change
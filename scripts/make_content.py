@@ -1,73 +1,534 @@
-from datetime import datetime, date, time, timezone
-import locale
+from email.utils import formatdate
+import argparse
+import subprocess
 import gzip
 from io import BytesIO
 import binascii
-import shutil
 import os
 import mimetypes
 import hashlib
+import re
+import brotli
 
-locale.setlocale(locale.LC_TIME, "en_US")
-dt = datetime.now()
-lm = dt.strftime("%a, %d %b %Y %H:%M:%S GMT")
+parser = argparse.ArgumentParser(description='Generates src/StaticContent.cpp from the data folder')
+parser.add_argument('--identity', action='store_true',
+                    help='Also embed uncompressed files for clients not supporting compression (uses a lot of flash)')
+parser.add_argument('--identity-max', type=int, default=16384, metavar='BYTES',
+                    help='Embed uncompressed text files up to this size even without --identity (default: %(default)s, 0 to disable)')
+parser.add_argument('--bundle', action='store_true',
+                    help='Bundle stylesheets and scripts of each page into one CSS and one JS file, removing unused CSS rules')
+parser.add_argument('--inline', action='store_true',
+                    help='Like --bundle, but inline the bundles into the page to serve a single document')
+args = parser.parse_args()
+if args.inline:
+    args.bundle = True
+
+def source_date():
+    """Date of the data folder, stable between runs on the same sources"""
+    if 'SOURCE_DATE_EPOCH' in os.environ:
+        return int(os.environ['SOURCE_DATE_EPOCH'])
+    try:
+        out = subprocess.run(['git', 'log', '-1', '--format=%ct', '--', './data'],
+                             capture_output=True, text=True, check=True).stdout.strip()
+        if out:
+            return int(out)
+    except (OSError, subprocess.CalledProcessError):
+        pass
+    return max(int(os.path.getmtime('./data/' + f)) for f in os.listdir('./data'))
+
+lm = formatdate(source_date(), usegmt=True)
 
 print('Last-modified : ', lm)
+
+def hashed_name(filename, raw):
+    """Inserts content hash in file name (bootstrap.min.css -> bootstrap.<sha>.min.css)"""
+    digest = hashlib.sha1(raw).hexdigest()[:10]
+    pos = filename.find('.min.')
+    if pos < 0:
+        pos = filename.rfind('.')
+    if pos < 0:
+        return f'{filename}.{digest}'
+    return f'{filename[:pos]}.{digest}{filename[pos:]}'
+
+CSS_LINK_RE = re.compile(r'<link\s[^>]*href="(?:\.\./|/)?www/([^"]+)"[^>]*>\s*', re.IGNORECASE)
+JS_SCRIPT_RE = re.compile(r'<script\s[^>]*src="(?:\.\./|/)?www/([^"]+)"[^>]*>\s*</script>\s*', re.IGNORECASE)
+
+def css_blocks(css):
+    """Splits CSS into (prelude, body) blocks, body is None for statements ending with ';'"""
+    blocks = []
+    i = 0
+    start = 0
+    depth = 0
+    prelude = None
+    quote = None
+    while i < len(css):
+        c = css[i]
+        if quote:
+            if c == '\\':
+                i += 1
+            elif c == quote:
+                quote = None
+        elif c in '"\'':
+            quote = c
+        elif css.startswith('/*', i):
+            end = css.find('*/', i + 2)
+            i = len(css) if end < 0 else end + 1
+        elif c == '{':
+            if depth == 0:
+                prelude = css[start:i].strip()
+                start = i + 1
+            depth += 1
+        elif c == '}':
+            depth -= 1
+            if depth == 0:
+                blocks.append((prelude, css[start:i]))
+                start = i + 1
+        elif c == ';' and depth == 0:
+            blocks.append((css[start:i].strip(), None))
+            start = i + 1
+        i += 1
+    return blocks
+
+def selector_used(selector, words):
+    """A selector is kept if all classes and ids it needs appear in pages or scripts"""
+    selector = re.sub(r':not\([^)]*\)', '', selector)
+    names = re.findall(r'[.#](-?[_a-zA-Z][\w-]*)', selector)
+    return all(name in words for name in names)
+
+def shake_css(css, words):
+    """Removes CSS rules not matching any class or id used by pages or scripts"""
+    out = []
+    for prelude, body in css_blocks(css):
+        prelude = re.sub(r'/\*.*?\*/', '', prelude, flags=re.DOTALL).strip()
+        if body is None:
+            out.append(prelude + ';')
+        elif prelude.startswith('@media') or prelude.startswith('@supports'):
+            inner = shake_css(body, words)
+            if inner:
+                out.append(prelude + '{' + inner + '}')
+        elif prelude.startswith('@'):
+            out.append(prelude + '{' + body + '}')
+        else:
+            selectors = [sel for sel in prelude.split(',') if selector_used(sel, words)]
+            if selectors:
+                out.append(','.join(selectors) + '{' + body + '}')
+    return ''.join(out)
+
+def replace_tags(regex, page, files, tag):
+    """Replaces the first tag referencing one of the files by tag, removes the others"""
+    first = True
+    def repl(m):
+        nonlocal first
+        if m.group(1) not in files:
+            return m.group(0)
+        if first:
+            first = False
+            return tag
+        return ''
+    return regex.sub(repl, page)
+
+def bundle_page(page_name, contents):
+    """Bundles stylesheets and scripts of a page, returns the list of bundled files"""
+    page = contents[page_name].decode('utf-8')
+    css_files = CSS_LINK_RE.findall(page)
+    js_files = JS_SCRIPT_RE.findall(page)
+    css_files = [f for f in css_files if f in contents]
+    js_files = [f for f in js_files if f in contents]
+    #Every word of page and scripts may be a class name (bootstrap builds many of them in JS)
+    words = set(re.findall(r'[\w-]+', page))
+    for f in js_files:
+        words.update(re.findall(r'[\w-]+', contents[f].decode('utf-8')))
+    stem = page_name.rsplit('.', 1)[0]
+    if css_files:
+        css = ''
+        for f in css_files:
+            text = contents[f].decode('utf-8')
+            before = len(text)
+            #Keep license header
+            license = re.match(r'\s*(/\*!.*?\*/)', text, re.DOTALL)
+            text = (license.group(1) if license else '') + shake_css(text, words)
+            print(f'Tree-shaking {f} : {before} -> {len(text)} bytes')
+            css += text
+        if args.inline:
+            tag = f'<style>{css}</style>\n'
+        else:
+            contents[f'{stem}.bundle.css'] = css.encode('utf-8')
+            tag = f'<link rel="stylesheet" href="../www/{stem}.bundle.css">\n'
+        page = replace_tags(CSS_LINK_RE, page, css_files, tag)
+    if js_files:
+        #Scripts are concatenated in page order
+        js = ';\n'.join(contents[f].decode('utf-8') for f in js_files)
+        if args.inline:
+            js = re.sub(r'</(script)', r'<\\/\1', js, flags=re.IGNORECASE)
+            tag = f'<script>{js}</script>\n'
+        else:
+            contents[f'{stem}.bundle.js'] = js.encode('utf-8')
+            tag = f'<script src="../www/{stem}.bundle.js"></script>\n'
+        page = replace_tags(JS_SCRIPT_RE, page, js_files, tag)
+    contents[page_name] = page.encode('utf-8')
+    return css_files + js_files
+
+def compress_gzip(data):
+    buf = BytesIO()
+    with gzip.GzipFile(mode='wb', fileobj=buf, compresslevel=9, mtime=0) as f_out:
+        f_out.write(data)
+    return buf.getvalue()
+
+def compress_brotli(data, mimetype):
+    mode = brotli.MODE_TEXT if mimetype and mimetype.startswith('text/') else brotli.MODE_GENERIC
+    return brotli.compress(data, mode=mode, quality=11)
+
+def write_array(out_f, name, data):
+    out_f.write(f'static const uint8_t {name}[] PROGMEM = {{')
+    for b in data:
+        hex_data = "0x{0:x},".format(b)
+        out_f.write(hex_data)
+    out_f.write('};\n')
+
+#Code of the static files handler, written after the file table
+HANDLER_CODE = """
+/**
+ * Finds a static file by URL (binary search, table is sorted)
+ * @param url URL of the file
+ * @return Pointer to the file or nullptr if not found
+ */
+static const StaticFile* findStaticFile(const char* url){
+	size_t low = 0;
+	size_t high = static_files_count;
+	while(low < high){
+		size_t mid = (low + high) / 2;
+		int cmp = strcmp(url, static_files[mid].path);
+		if(cmp == 0){
+			return &static_files[mid];
+		}else if(cmp < 0){
+			high = mid;
+		}else{
+			low = mid + 1;
+		}
+	}
+	return nullptr;
+}
+
+/**
+ * Checks if the client accepts an encoding (Accept-Encoding header)
+ * @param request Request to check
+ * @param encoding Encoding to look for ("identity" for no encoding)
+ * @return True if the encoding, or else *, is listed and not refused with q=0.
+ * Identity is also accepted when not listed, unless refused by *;q=0.
+ */
+bool acceptsEncoding(AsyncWebServerRequest *request, const char* encoding){
+	bool identity = (strcasecmp(encoding, "identity") == 0);
+	if(!request->hasHeader("Accept-Encoding")){
+		return identity;
+	}
+	String accept = request->header("Accept-Encoding");
+	const char* p = accept.c_str();
+	size_t encLen = strlen(encoding);
+	//1 if * is accepted, -1 if refused, 0 if not listed
+	int wildcard = 0;
+	while(*p){
+		while((*p == ' ') || (*p == ',')){
+			++p;
+		}
+		const char* token = p;
+		while(*p && (*p != ',') && (*p != ';') && (*p != ' ')){
+			++p;
+		}
+		bool match = ((size_t)(p - token) == encLen) && (strncasecmp(token, encoding, encLen) == 0);
+		bool star = ((p - token) == 1) && (*token == '*');
+		//Look for weight of this token
+		bool refused = false;
+		while(*p && (*p != ',')){
+			if((*p == 'q') && (p[1] == '=')){
+				refused = (atof(p + 2) <= 0.0);
+			}
+			++p;
+		}
+		if(match){
+			return !refused;
+		}
+		if(star){
+			wildcard = refused ? -1 : 1;
+		}
+	}
+	if(wildcard != 0){
+		return wildcard > 0;
+	}
+	return identity;
+}
+
+/**
+ * Checks a conditional request against an entity tag (If-None-Match header)
+ * Uses the weak comparison, W/ prefixes are ignored.
+ * @param request Request to check
+ * @param etag Quoted entity tag of the actual content
+ * @return True if the client copy matches, either listed or with *
+ */
+bool matchesETag(AsyncWebServerRequest *request, const char* etag){
+	if(!request->hasHeader("If-None-Match")){
+		return false;
+	}
+	String header = request->header("If-None-Match");
+	const char* p = header.c_str();
+	size_t tagLen = strlen(etag);
+	while(*p){
+		while((*p == ' ') || (*p == ',')){
+			++p;
+		}
+		if(*p == '*'){
+			return true;
+		}
+		if((p[0] == 'W') && (p[1] == '/')){
+			p += 2;
+		}
+		const char* tag = p;
+		while(*p && (*p != ',') && (*p != ' ')){
+			++p;
+		}
+		if(((size_t)(p - tag) == tagLen) && (strncmp(tag, etag, tagLen) == 0)){
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Parses a single byte range (Range header)
+ * @param header Range header value
+ * @param len Length of the data
+ * @param start First byte of the range
+ * @param end Last byte of the range (inclusive)
+ * @return 1 if the range is valid, 0 if the header must be ignored, -1 if the range is not satisfiable
+ */
+static int parseRange(const String& header, size_t len, size_t& start, size_t& end){
+	//Only single ranges are supported, others get the full content
+	if(!header.startsWith("bytes=") || (header.indexOf(',') >= 0)){
+		return 0;
+	}
+	const char* p = header.c_str() + 6;
+	char* dash;
+	if(*p == '-'){
+		//Suffix range (last N bytes)
+		size_t suffix = strtoul(p + 1, nullptr, 10);
+		if(suffix == 0){
+			return -1;
+		}
+		start = (suffix >= len) ? 0 : len - suffix;
+		end = len - 1;
+		return 1;
+	}
+	start = strtoul(p, &dash, 10);
+	if((dash == p) || (*dash != '-')){
+		return 0;
+	}
+	end = (dash[1] == '\\0') ? len - 1 : strtoul(dash + 1, nullptr, 10);
+	if(end >= len){
+		end = len - 1;
+	}
+	if((start >= len) || (start > end)){
+		return -1;
+	}
+	return 1;
+}
+
+/**
+ * Sends a static file, choosing the best variant the client can decode
+ * @param request Request to answer
+ * @param file File to be sent
+ */
+static void sendStaticFile(AsyncWebServerRequest *request, const StaticFile* file){
+	const StaticFileVariant* variant = nullptr;
+	for(size_t i=0;i<file->variantCount;++i){
+		const char* encoding = file->variants[i].encoding;
+		if(acceptsEncoding(request, encoding ? encoding : "identity")){
+			variant = &file->variants[i];
+			break;
+		}
+	}
+	//Without Accept-Encoding any encoding is allowed, identity is only preferred
+	if((variant == nullptr) && !request->hasHeader("Accept-Encoding")){
+		variant = &file->variants[file->variantCount - 1];
+	}
+	//Never send an encoding the client did not ask for
+	if(variant == nullptr){
+		AsyncWebServerResponse *response = request->beginResponse(406, "text/plain", "No acceptable encoding");
+		response->addHeader("Vary", "Accept-Encoding");
+		request->send(response);
+		return;
+	}
+	//If-None-Match takes precedence over If-Modified-Since
+	bool notModified;
+	if (request->hasHeader("If-None-Match")) {
+		notModified = matchesETag(request, variant->etag);
+	}else{
+		notModified = request->header("If-Modified-Since").equals(static_files_last_modified);
+	}
+	if (notModified) {
+		AsyncWebServerResponse * response = new AsyncBasicResponse(304); // Not modified
+		response->addHeader("Cache-Control", file->cacheControl);
+		response->addHeader("ETag", variant->etag);
+		response->addHeader("Vary", "Accept-Encoding");
+		request->send(response);
+		return;
+	}
+	size_t start = 0;
+	size_t end = variant->len - 1;
+	int code = 200;
+	char contentRange[48];
+	//Range is ignored if the client copy (If-Range, strong comparison) is outdated
+	if(request->hasHeader("Range") &&
+		(!request->hasHeader("If-Range") || request->header("If-Range").equals(variant->etag))){
+		int range = parseRange(request->header("Range"), variant->len, start, end);
+		if(range < 0){
+			AsyncWebServerResponse *response = request->beginResponse(416);
+			snprintf(contentRange, sizeof(contentRange), "bytes */%u", (unsigned)variant->len);
+			response->addHeader("Content-Range", contentRange);
+			request->send(response);
+			return;
+		}else if(range > 0){
+			code = 206;
+			snprintf(contentRange, sizeof(contentRange), "bytes %u-%u/%u", (unsigned)start, (unsigned)end, (unsigned)variant->len);
+		}
+	}
+	//Data is streamed directly from flash
+	AsyncWebServerResponse *response = request->beginResponse_P(code, file->mimetype, variant->data + start, end - start + 1);
+	if(code == 206){
+		response->addHeader("Content-Range", contentRange);
+	}
+	if(variant->encoding){
+		response->addHeader("Content-Encoding", variant->encoding);
+	}
+	response->addHeader("Accept-Ranges", "bytes");
+	response->addHeader("Cache-Control", file->cacheControl);
+	response->addHeader("ETag", variant->etag);
+	response->addHeader("Vary", "Accept-Encoding");
+	response->addHeader("Last-Modified", static_files_last_modified);
+	request->send(response);
+}
+
+/**
+ * Web handler serving all static files (pages or assets) of the table
+ */
+class StaticFilesHandler : public AsyncWebHandler
+{
+private:
+	bool _pages;        //!< True to serve pages, false to serve assets
+public:
+	StaticFilesHandler(bool pages) : _pages(pages) {}
+
+	bool canHandle(AsyncWebServerRequest *request) const override {
+		if(request->method() != HTTP_GET){
+			return false;
+		}
+		const StaticFile* file = findStaticFile(request->url().c_str());
+		return (file != nullptr) && (file->page == _pages);
+	}
+
+	void handleRequest(AsyncWebServerRequest *request) override {
+		sendStaticFile(request, findStaticFile(request->url().c_str()));
+	}
+
+	bool isRequestHandlerTrivial() const override {
+		return true;
+	}
+};
+
+AsyncWebHandler* registerStaticFiles(AsyncWebServer* webServer){
+	//Assets are public, pages handler is returned to set its authentication
+	webServer->addHandler(new StaticFilesHandler(false));
+	return &webServer->addHandler(new StaticFilesHandler(true));
+}
+"""
+
 totalBytes = 0
-files = []
 with open('./src/StaticContent.cpp', 'w') as out_f:
     out_f.write('#include "StaticContent.h"\n\n')
     out_f.write('//Automatically generated with make_content script, do not edit!\n\n')
-    for filename in os.listdir('./data'):
+    out_f.write('/**\n')
+    out_f.write(' * An encoded variant of a static file\n')
+    out_f.write(' */\n')
+    out_f.write('struct StaticFileVariant {\n')
+    out_f.write('\tconst char* encoding;                   //!< Content-Encoding of the data (nullptr for identity)\n')
+    out_f.write('\tconst uint8_t* data;                    //!< Pointer to data in flash\n')
+    out_f.write('\tsize_t len;                             //!< Data length\n')
+    out_f.write('\tconst char* etag;                       //!< ETag of this variant (quoted)\n')
+    out_f.write('};\n\n')
+    out_f.write('/**\n')
+    out_f.write(' * A static file\n')
+    out_f.write(' */\n')
+    out_f.write('struct StaticFile {\n')
+    out_f.write('\tconst char* path;                       //!< URL of the file\n')
+    out_f.write('\tconst char* mimetype;                   //!< Mime type\n')
+    out_f.write('\tconst char* cacheControl;               //!< Cache-Control header value\n')
+    out_f.write('\tbool page;                              //!< True for pages, false for assets\n')
+    out_f.write('\tconst StaticFileVariant* variants;      //!< Encoded variants, ordered by preference\n')
+    out_f.write('\tsize_t variantCount;                    //!< Number of variants\n')
+    out_f.write('};\n\n')
+    #Read all files, assets (everything except HTML pages) get a content-hashed URL
+    contents = {}
+    urls = {}
+    for filename in sorted(os.listdir('./data')):
         absPath = './data/' + filename
         if os.path.isfile(absPath):
-            print('Compressing file ', absPath)
-            buf = BytesIO()
             with open(absPath, 'rb') as f_in:
-                with gzip.GzipFile(mode='wb', fileobj=buf) as f_out:
-                    shutil.copyfileobj(f_in, f_out)
-            compressed = buf.getvalue()
-            print('Compressed Data:', len(compressed), ' bytes')
-            totalBytes += len(compressed)
-            mimetype = mimetypes.guess_type(filename)[0]
-            print('mimetype : ', mimetype)
-            etag = hashlib.sha1(compressed).hexdigest()
-            files.append(filename)
-            f_n = filename.replace('.', "_").replace('-', '_')
-            out_f.write(f'static const size_t {f_n}_len PROGMEM = {len(compressed)};\n')
-            out_f.write(f'static const char* {f_n}_mimetype PROGMEM = "{mimetype}";\n')
-            out_f.write(f'static const char* {f_n}_etag PROGMEM = "{etag}";\n')
-            out_f.write(f'const uint8_t {f_n}_data[] PROGMEM = {{')
-            for b in compressed:
-                hex_data = "0x{0:x},".format(b)
-                out_f.write(hex_data)
-            out_f.write('};\n\n')
+                contents[filename] = f_in.read()
+    if args.bundle:
+        bundled = set()
+        for filename in [f for f in contents if f.endswith('.html')]:
+            bundled.update(bundle_page(filename, contents))
+        for filename in bundled:
+            del contents[filename]
+    for filename, raw in contents.items():
+        if filename.endswith('.html'):
+            urls[filename] = filename
+        else:
+            urls[filename] = hashed_name(filename, raw)
+    #Rewrite references to hashed assets in pages
+    for filename in contents:
+        if filename.endswith('.html'):
+            page = contents[filename].decode('utf-8')
+            for asset, url in urls.items():
+                page = page.replace(f'www/{asset}', f'www/{url}')
+            contents[filename] = page.encode('utf-8')
+    for filename, raw in contents.items():
+        absPath = './data/' + filename
+        mimetype = mimetypes.guess_type(filename)[0]
+        print('mimetype : ', mimetype)
+        f_n = filename.replace('.', "_").replace('-', '_')
+        #Variants ordered by preference
+        variants = []
+        print('Compressing file ', absPath)
+        variants.append(('br', compress_brotli(raw, mimetype)))
+        variants.append(('gzip', compress_gzip(raw)))
+        #Small text files are also served uncompressed, others get 406 without a supported encoding
+        text = mimetype and (mimetype.startswith('text/') or mimetype.endswith('javascript'))
+        if args.identity or (text and len(raw) <= args.identity_max):
+            variants.append((None, raw))
+        for encoding, data in variants:
+            print('  ', encoding or 'identity', ':', len(data), ' bytes')
+            totalBytes += len(data)
+            write_array(out_f, f'{f_n}_{encoding or "identity"}_data', data)
+        out_f.write(f'static const StaticFileVariant {f_n}_variants[] = {{\n')
+        for encoding, data in variants:
+            etag = hashlib.sha1(data).hexdigest()
+            enc = f'"{encoding}"' if encoding else 'nullptr'
+            out_f.write(f'\t{{{enc}, {f_n}_{encoding or "identity"}_data, {len(data)}, "\\"{etag}\\""}},\n')
+        out_f.write('};\n\n')
     out_f.write(f'static const char* static_files_last_modified PROGMEM = "{lm}";\n')
-    out_f.write(f'static const char* cache_control_header PROGMEM = "public, max-age=31536000";\n')
-    out_f.write('AsyncWebHandler* registerStaticFiles(AsyncWebServer* webServer){\n')
-    out_f.write('\tAsyncWebHandler* ret = nullptr;\n')
-    for f in files:
+    out_f.write('//Hashed assets never change for a given URL, pages must be revalidated to pick up new asset URLs\n')
+    out_f.write(f'static const char cache_control_immutable[] = "public, max-age=31536000, immutable";\n')
+    out_f.write(f'static const char cache_control_page[] = "no-cache";\n\n')
+    out_f.write('//Sorted by path for binary search\n')
+    out_f.write('static constexpr StaticFile static_files[] = {\n')
+    for f in sorted(contents, key=lambda name: f'/www/{urls[name]}'):
         f_n = f.replace('.', "_").replace('-', '_')
-        out_f.write('\t')
-        if(f == 'config.html'):
-            out_f.write('ret = &')
-        out_f.write(f'webServer->on("/www/{f}", HTTP_GET, [=](AsyncWebServerRequest *request){{\n')
-        out_f.write('\t\tif (request->header("If-Modified-Since") == static_files_last_modified) {\n')
-        out_f.write('\t\t\trequest->send(304);\n')
-        out_f.write(f'\t\t}}else if (request->hasHeader("If-None-Match") && request->header("If-None-Match").equals({f_n}_etag)) {{\n')
-        out_f.write('\t\t\tAsyncWebServerResponse * response = new AsyncBasicResponse(304); // Not modified\n')
-        out_f.write('\t\t\tresponse->addHeader("Cache-Control", cache_control_header);\n')
-        out_f.write(f'\t\t\tresponse->addHeader("ETag", {f_n}_etag);\n')
-        out_f.write('\t\t\trequest->send(response);\n')
-        out_f.write('\t\t}else{\n')
-        out_f.write(f'\t\t\tAsyncWebServerResponse *response = request->beginResponse_P(200, {f_n}_mimetype, {f_n}_data, {f_n}_len);\n')
-        out_f.write('\t\t\tresponse->addHeader("Content-Encoding", "gzip");\n')
-        out_f.write('\t\t\tresponse->addHeader("Cache-Control", cache_control_header);\n')
-        out_f.write(f'\t\t\tresponse->addHeader("ETag", {f_n}_etag);\n')
-        out_f.write('\t\t\trequest->send(response);\n')
-        out_f.write('\t\t}\n')
-        out_f.write('\t});\n\n')
-        
-    out_f.write('\treturn ret;\n}\n')
+        page = f.endswith('.html')
+        cache = 'cache_control_page' if page else 'cache_control_immutable'
+        mimetype = mimetypes.guess_type(f)[0]
+        out_f.write(f'\t{{"/www/{urls[f]}", "{mimetype}", {cache}, {"true" if page else "false"}, '
+                    f'{f_n}_variants, sizeof({f_n}_variants)/sizeof({f_n}_variants[0])}},\n')
+    out_f.write('};\n')
+    out_f.write('static constexpr size_t static_files_count = sizeof(static_files)/sizeof(static_files[0]);\n')
+    out_f.write(HANDLER_CODE)
 
 print('Content total bytes : ', totalBytes)
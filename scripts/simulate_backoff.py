@@ -0,0 +1,129 @@
+import argparse
+import heapq
+import random
+
+parser = argparse.ArgumentParser(description='Simulates a fleet of devices reconnecting to an access point after it reboots')
+parser.add_argument('--devices', type=int, default=200, help='Number of devices')
+parser.add_argument('--capacity', type=int, default=10,
+                    help='Number of connections (association + DHCP) the AP can handle at the same time')
+parser.add_argument('--connect-time', type=float, default=2.0, help='Duration of a successful connection in s')
+parser.add_argument('--outage', type=float, default=30.0, help='Duration of the AP reboot in s')
+parser.add_argument('--policy', choices=['fixed', 'jitter', 'both'], default='both',
+                    help='fixed : previous hard-coded timings, jitter : ESPEasyCfgJitterBackoff')
+parser.add_argument('--seed', type=int, default=1)
+args = parser.parse_args()
+
+# Timings of ESPEasyCfg.cpp, in seconds
+AP_MIN_TIME = 10.0
+SCHEDULE_TIME = 0.1
+
+
+class FixedPolicy:
+    """Timings before the backoff policy : 60 s first timeout, 120 s in AP, 10 s next timeouts"""
+    def __init__(self, rnd):
+        self.reset()
+
+    def reset(self):
+        self.attempt = 0
+
+    def next_delay(self):
+        delay = 0.0 if self.attempt == 0 else 120.0
+        self.attempt += 1
+        return delay
+
+    def lost_delay(self):
+        return self.next_delay()
+
+    def connect_timeout(self):
+        return 60.0 if self.attempt <= 1 else 10.0
+
+
+class JitterPolicy:
+    """Python port of ESPEasyCfgJitterBackoff with default parameters"""
+    def __init__(self, rnd, first_retry=1.0, base=30.0, cap=600.0, first_timeout=60.0, retry_timeout=10.0):
+        self.rnd = rnd
+        self.first_retry = first_retry
+        self.base = base
+        self.cap = cap
+        self.first_timeout = first_timeout
+        self.retry_timeout = retry_timeout
+        self.reset()
+
+    def reset(self):
+        self.sleep = self.base
+        self.attempt = 0
+
+    def next_delay(self):
+        upper = max(self.base, min(self.cap, self.sleep * 3))
+        self.sleep = min(self.cap, self.rnd.uniform(self.base, upper))
+        self.attempt += 1
+        return self.sleep
+
+    def lost_delay(self):
+        if self.attempt != 0:
+            return self.next_delay()
+        # Fast path, only after an established connection
+        self.attempt += 1
+        return self.rnd.uniform(0, self.first_retry)
+
+    def connect_timeout(self):
+        return self.first_timeout if self.attempt == 0 else self.retry_timeout
+
+
+def simulate(policy_class):
+    rnd = random.Random(args.seed)
+    events = []
+    in_progress = 0
+    peak = 0
+    attempts = 0
+    rejected = 0
+    connected_at = {}
+    policies = [policy_class(rnd) for _ in range(args.devices)]
+    for dev in range(args.devices):
+        # Connection lost when the AP goes down, detected within a beacon period
+        heapq.heappush(events, (rnd.uniform(0, 0.5), dev, 'lost'))
+    while events:
+        now, dev, what = heapq.heappop(events)
+        policy = policies[dev]
+        if what == 'lost':
+            heapq.heappush(events, (now + policy.lost_delay(), dev, 'connect'))
+        elif what == 'connect':
+            attempts += 1
+            timeout = policy.connect_timeout()
+            if now >= args.outage and in_progress < args.capacity:
+                in_progress += 1
+                peak = max(peak, in_progress)
+                heapq.heappush(events, (now + args.connect_time, dev, 'done'))
+            else:
+                # AP down or overloaded : the attempt times out
+                rejected += 1
+                heapq.heappush(events, (now + timeout, dev, 'timeout'))
+        elif what == 'done':
+            in_progress -= 1
+            policy.reset()
+            connected_at[dev] = now
+        elif what == 'timeout':
+            retry = policy.next_delay()
+            if retry >= AP_MIN_TIME:
+                # Device waits in AP mode, switching mode takes some time
+                retry += SCHEDULE_TIME
+            heapq.heappush(events, (now + retry, dev, 'connect'))
+    times = sorted(connected_at.values())
+    return {
+        'attempts': attempts,
+        'rejected': rejected,
+        'peak': peak,
+        'median': times[len(times) // 2],
+        'p90': times[int(len(times) * 0.9)],
+        'last': times[-1],
+    }
+
+
+policies = {'fixed': FixedPolicy, 'jitter': JitterPolicy}
+names = list(policies) if args.policy == 'both' else [args.policy]
+print('%d devices, AP capacity %d, outage %.0f s' % (args.devices, args.capacity, args.outage))
+print('%-8s %9s %9s %6s %9s %9s %9s' % ('policy', 'attempts', 'rejected', 'peak', 'median s', 'p90 s', 'last s'))
+for name in names:
+    r = simulate(policies[name])
+    print('%-8s %9d %9d %6d %9.1f %9.1f %9.1f' % (name, r['attempts'], r['rejected'], r['peak'],
+                                                  r['median'], r['p90'], r['last']))
@@ -7,7 +7,6 @@
 #include <esp_task_wdt.h>
 #elif defined(ESP8266)
 #include <ESP8266WiFi.h>
-#define WIFI_AUTH_OPEN ENC_TYPE_NONE
 #else
 #error Platform not supported
 #endif
@@ -15,11 +14,226 @@
 #include "ESPEasyCfgParameterManagerJSON.h"
 #include "ESPEasyCfgConfiguration.h"
 #include "StaticContent.h"
+#include "ESPEasyCfgGzipStream.h"
 
 #define CFG_VERSION "1.0.0"
 #define UNUSED_PIN 0xFF
-#define AP_RECO_TIME 120000
-#define AP_RECO_TIMEOUT 10000
+#define AP_MIN_TIME 10000
+#define JSON_GZIP_THRESHOLD 1024
+#define JSON_GZIP_SLICE 512
+#define MONITOR_MAX_WAIT 10000
+#define SWITCH_POLL_TIME 50
+#define FAST_CONNECT_TIMEOUT 3000
+#define PROBE_TIMEOUT 3000
+#define PROBE_DWELL_TIME 100
+#define SCAN_POLL_TIME 100
+#define SCAN_REUSE_TIME 30000
+#define SCAN_MAX_AGE 30000
+//Roaming is opt-in (setRoaming), it adds background scans
+#define ROAM_THRESHOLD 0
+#define ROAM_HYSTERESIS 8
+#define ROAM_SAMPLE_TIME 2000
+#define ROAM_SCAN_INTERVAL 60000
+#define INFO_RSSI_TTL 5000
+#define INFO_COUNTER_TTL 1000
+#define EVENT_TASK_STACK 4096
+#define SERIAL_POLL_TIME 50
+#define SERIAL_IDLE_POLL_TIME 1000
+#define MONITOR_TASK_STACK 8192
+//HTML attributes of IP address inputs (empty or dotted quad)
+#define IP_ADDRESS_ATTRIBUTES "{\"pattern\":\"^$|^((25[0-5]|2[0-4]\\\\d|1?\\\\d?\\\\d)\\\\.){3}(25[0-5]|2[0-4]\\\\d|1?\\\\d?\\\\d)$\"}"
+
+//Formats an IP address into a buffer
+static void formatIP(char* value, size_t size, const IPAddress& ip)
+{
+    snprintf(value, size, "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+}
+
+//Rejection of an import, answered once its body is received
+struct ImportRejection {
+    int code;                               //!< HTTP status
+    uint32_t retryAfter;                    //!< Retry-After in s
+};
+
+//Names of states, as pushed to event clients
+static const char* const state_names[] = {"Connecting", "AP", "Connected", "WillConnect", "Reconfigured"};
+
+//Connectivity check URLs of common operating systems (sorted)
+static const char* const captive_probe_urls[] = {
+    "/canonical.html",              //Firefox
+    "/connecttest.txt",             //Windows 10 and later
+    "/gen_204",                     //Android
+    "/generate_204",                //Android, Chrome OS
+    "/hotspot-detect.html",         //iOS, macOS
+    "/library/test/success.html",   //Older iOS
+    "/ncsi.txt",                    //Windows 7 and 8
+    "/redirect",                    //Windows
+    "/success.txt",                 //Firefox
+};
+
+/**
+ * Handler of OS connectivity checks, redirecting them to the portal
+ * so that the portal page pops up
+ */
+class CaptiveProbeHandler : public AsyncWebHandler
+{
+private:
+    ArRequestHandlerFunction _onRequest;    //!< Function sending the redirection
+public:
+    CaptiveProbeHandler(ArRequestHandlerFunction onRequest) : _onRequest(onRequest) {}
+
+    bool canHandle(AsyncWebServerRequest *request) const override {
+        if((request->method() != HTTP_GET) && (request->method() != HTTP_HEAD)){
+            return false;
+        }
+        const char* url = request->url().c_str();
+        size_t lo = 0;
+        size_t hi = sizeof(captive_probe_urls) / sizeof(captive_probe_urls[0]);
+        while(lo < hi){
+            size_t mid = (lo + hi) / 2;
+            int cmp = strcmp(url, captive_probe_urls[mid]);
+            if(cmp == 0){
+                return true;
+            }else if(cmp < 0){
+                hi = mid;
+            }else{
+                lo = mid + 1;
+            }
+        }
+        return false;
+    }
+
+    void handleRequest(AsyncWebServerRequest *request) override {
+        _onRequest(request);
+    }
+
+    bool isRequestHandlerTrivial() const override {
+        return true;
+    }
+};
+
+#ifdef ESP32
+/**
+ * Holds the parameter lock for a scope
+ * Web handlers run in the async_tcp task and serial provisioning in the
+ * monitor task. The lock covers parameters and session keys, as applying
+ * a new password renews the keys. On ESP8266, both run from loop(), no
+ * lock is needed.
+ */
+class ParamLock
+{
+private:
+    SemaphoreHandle_t _mutex;               //!< Recursive mutex
+public:
+    ParamLock(SemaphoreHandle_t mutex) : _mutex(mutex) { xSemaphoreTakeRecursive(_mutex, portMAX_DELAY); }
+    ~ParamLock() { xSemaphoreGiveRecursive(_mutex); }
+};
+#define PARAM_LOCK() ParamLock paramLock(_paramMutex)
+#else
+#define PARAM_LOCK()
+#endif
+
+/**
+ * Body of a gzip compressed JSON response, produced as the socket drains
+ * The document is serialized again for each slice instead of being
+ * buffered, as AsyncJsonResponse does. Allocated on the heap, as the
+ * encoder is too large for the web server stack.
+ */
+class GzipJsonFiller : public Print
+{
+private:
+    /**
+     * Copies a slice of the serialized document
+     */
+    class SlicePrint : public Print
+    {
+    private:
+        size_t _skip;                       //!< Number of bytes to skip
+        uint8_t* _dest;                     //!< Destination of the slice
+        size_t _size;                       //!< Size of the destination
+        size_t _len;                        //!< Number of bytes copied
+    public:
+        SlicePrint(size_t skip, uint8_t* dest, size_t size) : _skip(skip), _dest(dest), _size(size), _len(0) {}
+        size_t write(uint8_t c) override {
+            if(_skip > 0){
+                --_skip;
+                return 1;
+            }
+            if(_len >= _size){
+                return 0;
+            }
+            _dest[_len++] = c;
+            return 1;
+        }
+        inline size_t length() const { return _len; }
+    };
+
+    AsyncJsonResponse* _json;               //!< Response holding the document (owned, never sent)
+    String _pending;                        //!< Compressed bytes not yet sent
+    size_t _pendingPos;                     //!< Position of next byte of _pending
+    ESPEasyCfgGzipStream _gzip;             //!< Encoder writing to this object
+    size_t _length;                         //!< Length of the serialized document
+    size_t _consumed;                       //!< Number of document bytes given to the encoder
+    bool _finished;                         //!< True once the gzip trailer is produced
+    uint8_t _slice[JSON_GZIP_SLICE];        //!< Slice of the document being compressed
+
+public:
+    GzipJsonFiller(AsyncJsonResponse* json, size_t length) :
+        _json(json), _pendingPos(0), _gzip(*this), _length(length), _consumed(0), _finished(false) {}
+
+    ~GzipJsonFiller() {
+        delete _json;
+    }
+
+    size_t write(uint8_t c) override {
+        return write(&c, 1);
+    }
+
+    size_t write(const uint8_t *buffer, size_t size) override {
+        //Binary safe, as the length is given
+        _pending.concat((const char*)buffer, size);
+        return size;
+    }
+
+    /**
+     * Reads next compressed bytes
+     * @return Number of bytes written to buffer, 0 at the end
+     */
+    size_t read(uint8_t* buffer, size_t maxLen) {
+        size_t len = 0;
+        while(len < maxLen){
+            if(_pendingPos >= _pending.length()){
+                _pending = "";
+                _pendingPos = 0;
+                if(_consumed < _length){
+                    SlicePrint slice(_consumed, _slice, sizeof(_slice));
+                    serializeJson(_json->getRoot(), slice);
+                    if(slice.length() == 0){
+                        //Document shorter than measured
+                        _consumed = _length;
+                        continue;
+                    }
+                    _consumed += slice.length();
+                    _gzip.write(_slice, slice.length());
+                }else if(!_finished){
+                    _gzip.finish();
+                    _finished = true;
+                }else{
+                    break;
+                }
+                continue;
+            }
+            size_t n = _pending.length() - _pendingPos;
+            if(n > (maxLen - len)){
+                n = maxLen - len;
+            }
+            memcpy(buffer + len, _pending.c_str() + _pendingPos, n);
+            _pendingPos += n;
+            len += n;
+        }
+        return len;
+    }
+};
 
 #ifdef ESP32
 void ESPEasyCfgMonitorTask(void* instance)
@@ -28,6 +242,13 @@ void ESPEasyCfgMonitorTask(void* instance)
     obj->monitorState();
     vTaskDelete( NULL );
 }
+
+void ESPEasyCfgEventTask(void* instance)
+{
+    ESPEasyCfg* obj = reinterpret_cast<ESPEasyCfg*>(instance);
+    obj->dispatchTask();
+    vTaskDelete( NULL );
+}
 #endif
 
 ESPEasyCfg::ESPEasyCfg(AsyncWebServer *webServer) :
@@ -36,20 +257,98 @@ ESPEasyCfg::ESPEasyCfg(AsyncWebServer *webServer) :
     _iotPass("_iotPass", "IoT password", "", "Configuration password"),
     _wifiSSID("_wifiSSID", "WiFi SSID", "", "Name of the WiFi network"),
     _wifiPass("_wifiPass", "WiFi password", "", "Password of WiFi network"),
-    _paramGrp("Global settings"), _state(ESPEasyCfgState::WillConnect),
-     _cfgHandler(nullptr), _dnsServer(nullptr), _paramManager(nullptr),
+    _wifiPriority("_wifiPriority", "WiFi priority", 0, "Highest priority network in range is used first"),
+    _staticIP("_staticIP", "IP address", "", "Leave empty to use DHCP"),
+    _staticMask("_staticMask", "Subnet mask", "255.255.255.0", "Subnet mask"),
+    _staticGateway("_staticGateway", "Gateway", "", "Gateway address"),
+    _staticDNS("_staticDNS", "DNS server", "", "Leave empty to use gateway"),
+    _paramGrp("Global settings"), _ipGrp("IP configuration"),
+    _ipInfo("IP address", [](char* value, size_t size){ formatIP(value, size, WiFi.localIP()); },
+            ESPEasyCfgInfoRefresh::OnStateChange),
+    _maskInfo("Subnet mask", [](char* value, size_t size){ formatIP(value, size, WiFi.subnetMask()); },
+            ESPEasyCfgInfoRefresh::OnStateChange),
+    _gatewayInfo("Gateway address", [](char* value, size_t size){ formatIP(value, size, WiFi.gatewayIP()); },
+            ESPEasyCfgInfoRefresh::OnStateChange),
+    _dnsInfo("DNS server", [](char* value, size_t size){ formatIP(value, size, WiFi.dnsIP()); },
+            ESPEasyCfgInfoRefresh::OnStateChange),
+    _macInfo("MAC address", [](char* value, size_t size){
+                uint8_t mac[6];
+                WiFi.macAddress(mac);
+                snprintf(value, size, "%02x:%02x:%02x:%02x:%02x:%02x", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+            }),
+    _channelInfo("WiFi channel", [](char* value, size_t size){ snprintf(value, size, "%d", (int)WiFi.channel()); },
+            ESPEasyCfgInfoRefresh::OnStateChange),
+    _rssiInfo("WiFi RSSI", [](char* value, size_t size){ snprintf(value, size, "%d", (int)WiFi.RSSI()); },
+            ESPEasyCfgInfoRefresh::TTL, INFO_RSSI_TTL),
+    _uptimeInfo("Uptime", [](char* value, size_t size){
+                unsigned long s = millis() / 1000;
+                snprintf(value, size, "%lud %02lu:%02lu:%02lu", s / 86400, (s / 3600) % 24, (s / 60) % 60, s % 60);
+            }, ESPEasyCfgInfoRefresh::TTL, INFO_COUNTER_TTL),
+    _droppedInfo("Dropped events", [this](char* value, size_t size){
+                snprintf(value, size, "%lu", (unsigned long)getDroppedEvents());
+            }, ESPEasyCfgInfoRefresh::TTL, INFO_COUNTER_TTL),
+    _rejectedInfo("Rejected requests", [this](char* value, size_t size){
+                snprintf(value, size, "%lu", (unsigned long)_admission.getRejected());
+            }, ESPEasyCfgInfoRefresh::TTL, INFO_COUNTER_TTL),
+    _firstInfo(nullptr), _stateGeneration(1), _state(ESPEasyCfgState::WillConnect),
+     _cfgHandler(nullptr), _events(nullptr), _authRequired(false),
+     _importer(nullptr), _importRequest(nullptr),
+     _serial(nullptr), _serialLen(0), _serialOverflow(false), _configGeneration(1), _scanEventCount(0),
+     _dnsServer(nullptr), _paramManager(nullptr),
      _lastCon(0), _lastApUsage(0), _ledPin(UNUSED_PIN), _ledActiveLow(false),
-     _switchPin(UNUSED_PIN), _scanCount(-1)
+     _switchPin(UNUSED_PIN), _reportedDrops(0), _jsonGzipThreshold(JSON_GZIP_THRESHOLD),
+     _connectStart(0), _connTimeout(0), _lastLedChange(0), _ledState(false),
+     _lastPrint(0), _fastReconnect(true),
+     _connectPhase(ConnectPhase::Full), _phaseStart(0), _probed(false), _network(0),
+     _candidateCount(0), _candidateIndex(0), _probeScanCount(0), _probeChannel(0),
+     _backoff(&_defaultBackoff), _retryStart(0), _retryDelay(0),
+     _roamThreshold(ROAM_THRESHOLD), _roamHysteresis(ROAM_HYSTERESIS), _rssiAvg(0),
+     _lastRssiSample(0), _lastRoamScan(0), _roamScanning(false), _roamScanCount(0),
+     _powerMode(ESPEasyCfgPowerMode::Modem), _listenInterval(3),
+     _appliedPowerMode(ESPEasyCfgPowerMode::None), _powerModeApplied(false), _lowLatency(0),
+#ifdef ESP32
+     _monitorTask(nullptr), _wifiEventId(0), _eventTaskEnabled(true), _eventTaskCore(tskNO_AFFINITY),
+     _eventTaskPriority(1), _eventTask(nullptr), _paramMutex(xSemaphoreCreateRecursiveMutex()), _serialEvent(false)
+#else
+     _wakeUp(false), _lastRun(0), _nextRun(0)
+#endif
 {
     //Add built-in parameters to the group
     _paramGrp.add(&_iotName);
     _paramGrp.add(&_iotPass);
     _paramGrp.add(&_wifiSSID);
     _paramGrp.add(&_wifiPass);
+    _paramGrp.add(&_wifiPriority);
     _iotPass.setInputType("password");
     _wifiPass.setInputType("password");
     _wifiSSID.setInputType("ssid");
     _iotName.setExtraAttributes("{\"required\":\"\"}");
+    //Static IP configuration, in its own group
+    _ipGrp.add(&_staticIP);
+    _ipGrp.add(&_staticMask);
+    _ipGrp.add(&_staticGateway);
+    _ipGrp.add(&_staticDNS);
+    _staticIP.setExtraAttributes(IP_ADDRESS_ATTRIBUTES);
+    _staticMask.setExtraAttributes(IP_ADDRESS_ATTRIBUTES);
+    _staticGateway.setExtraAttributes(IP_ADDRESS_ATTRIBUTES);
+    _staticDNS.setExtraAttributes(IP_ADDRESS_ATTRIBUTES);
+    _paramGrp.add(&_ipGrp);
+    //Additional WiFi networks, each in its own group
+    for(uint8_t i=0;i<(ESPEASYCFG_MAX_NETWORKS-1);++i){
+        _networks[i].setIndex(i+1);
+        _paramGrp.add(_networks[i].getGroup());
+    }
+    //Built-in device informations
+    addInfo(&_ipInfo);
+    addInfo(&_maskInfo);
+    addInfo(&_gatewayInfo);
+    addInfo(&_dnsInfo);
+    addInfo(&_macInfo);
+    addInfo(&_channelInfo);
+    addInfo(&_rssiInfo);
+    addInfo(&_uptimeInfo);
+    addInfo(&_droppedInfo);
+    addInfo(&_rejectedInfo);
 }
 
 ESPEasyCfg::ESPEasyCfg(AsyncWebServer *webServer, const char* thingName) :
@@ -60,6 +359,18 @@ ESPEasyCfg::ESPEasyCfg(AsyncWebServer *webServer, const char* thingName) :
 
 ESPEasyCfg::~ESPEasyCfg()
 {
+#ifdef ESP32
+    if(_monitorTask != nullptr){
+        vTaskDelete(_monitorTask);
+    }
+    if(_eventTask != nullptr){
+        vTaskDelete(_eventTask);
+    }
+    if(_wifiEventId != 0){
+        WiFi.removeEvent(_wifiEventId);
+    }
+    vSemaphoreDelete(_paramMutex);
+#endif
     delete _cfgHandler;
     delete _dnsServer;
     delete _paramManager;
@@ -67,11 +378,21 @@ ESPEasyCfg::~ESPEasyCfg()
 
 void ESPEasyCfg::toJSON(ArduinoJson::JsonArray& arr, ESPEasyCfgParameterGroup* first)
 {
-    ESPEasyCfgAbstractParameter* param = first->getFirst();
+    groupToJSON(arr, first);
+    //Recursive call if a parameter group follow this one
+    ESPEasyCfgParameterGroup* next = first->getNext();
+    if(next != nullptr){
+        toJSON(arr, next);
+    }
+}
+
+void ESPEasyCfg::groupToJSON(ArduinoJson::JsonArray& arr, ESPEasyCfgParameterGroup* grp)
+{
+    ESPEasyCfgAbstractParameter* param = grp->getFirst();
     //Create an entry in the array
     JsonObject paramCol = arr.add<JsonObject>();
     //Put name of the parameter group
-    paramCol["name"] = first->getName();
+    paramCol["name"] = grp->getName();
     //Create array of parameters
     JsonArray paramArr = paramCol["parameters"].to<JsonArray>();
     //Create JSON entry for each parameter in the group
@@ -86,14 +407,25 @@ void ESPEasyCfg::toJSON(ArduinoJson::JsonArray& arr, ESPEasyCfgParameterGroup* f
         }
         param = param->getNextParameter();
     }
-    //Recursive call if a parameter group follow this one
-    ESPEasyCfgParameterGroup* next = first->getNext();
-    if(next != nullptr){
-        toJSON(arr, next);
+}
+
+void ESPEasyCfg::indexToJSON(ArduinoJson::JsonArray& arr)
+{
+    for(ESPEasyCfgParameterGroup* grp = &_paramGrp; grp != nullptr; grp = grp->getNext()){
+        uint8_t count = 0;
+        for(ESPEasyCfgAbstractParameter* param = grp->getFirst(); param != nullptr; param = param->getNextParameter()){
+            if(!param->isHidden()){
+                ++count;
+            }
+        }
+        JsonObject obj = arr.add<JsonObject>();
+        obj["name"] = grp->getName();
+        obj["count"] = count;
     }
 }
 
-void ESPEasyCfg::fromJSON(ArduinoJson::JsonObject& json, ESPEasyCfgParameterGroup* first, String& msg, int8_t& action)
+void ESPEasyCfg::fromJSON(ArduinoJson::JsonObject& json, ESPEasyCfgParameterGroup* first, String& msg, int8_t& action,
+                            bool& persistedChanged)
 {
     ESPEasyCfgAbstractParameter* param = first->getFirst();
     //Got through all parameters
@@ -101,47 +433,41 @@ void ESPEasyCfg::fromJSON(ArduinoJson::JsonObject& json, ESPEasyCfgParameterGrou
     {
         if(json[param->getIdentifier()].is<const char*>()){
             const char* val = json[param->getIdentifier()];
-            param->setValue(val, msg, action, true);
+            if(param->getPersistence() == ESPEasyCfgPersistence::Persisted){
+                //Only a real change of a persisted value needs a flash write
+                String old = param->toString();
+                param->setValue(val, msg, action, true);
+                persistedChanged |= !old.equals(param->toString());
+            }else{
+                param->setValue(val, msg, action, true);
+            }
         }
         param = param->getNextParameter();
     }
     //Recursive call if a parameter group follow this one
     ESPEasyCfgParameterGroup* next = first->getNext();
     if(next != nullptr){
-        fromJSON(json, next, msg, action);
+        fromJSON(json, next, msg, action, persistedChanged);
     }
 }
 
-void ESPEasyCfg::addInfosPairToJSON(ArduinoJson::JsonArray& arr, const char* name, const String& value)
+void ESPEasyCfg::addInfosToJSON(ArduinoJson::JsonArray& arr)
 {
-    //Create an entry in the array
-    JsonObject pair = arr.add<JsonObject>();
-    //Put name of the parameter group
-    pair["name"] = name;
-    pair["value"] = value;
+    for(ESPEasyCfgInfo* info = _firstInfo; info != nullptr; info = info->getNext()){
+        //Create an entry in the array
+        JsonObject pair = arr.add<JsonObject>();
+        pair["name"] = info->getName();
+        pair["value"] = info->getValue(_stateGeneration);
+    }
 }
 
-void ESPEasyCfg::addInfosToJSON(ArduinoJson::JsonArray& arr)
+void ESPEasyCfg::addInfo(ESPEasyCfgInfo* info)
 {
-    addInfosPairToJSON(arr, "IP address", WiFi.localIP().toString());
-    addInfosPairToJSON(arr, "Subnet mask", WiFi.subnetMask().toString());
-    addInfosPairToJSON(arr, "Gateway address", WiFi.gatewayIP().toString());
-    addInfosPairToJSON(arr, "DNS server", WiFi.dnsIP().toString());
-    byte mac[6];                     // the MAC address of your Wifi shield
-    WiFi.macAddress(mac);
-    String macAddr = "";
-    for(uint8_t i=0;i<6;++i){
-        if(mac[i] < 0x10){
-            macAddr += "0";
-        }
-        macAddr += String(mac[i], HEX);
-        if(i<5)
-            macAddr += ':';
+    ESPEasyCfgInfo** last = &_firstInfo;
+    while(*last != nullptr){
+        last = &(*last)->_next;
     }
-    addInfosPairToJSON(arr, "MAC address", macAddr.c_str());
-
-    addInfosPairToJSON(arr, "WiFi channel", String(WiFi.channel(), DEC));
-    addInfosPairToJSON(arr, "WiFi RSSI", String(WiFi.RSSI(), DEC));
+    *last = info;
 }
 
 void ESPEasyCfg::begin()
@@ -150,19 +476,37 @@ void ESPEasyCfg::begin()
     _wifiSSID.setValidator([this](ESPEasyCfgParameter<String> *param, String newValue, String &msg, int8_t& action) -> bool{
         if((newValue != param->getValue()) || (_state == ESPEasyCfgState::AP))
         {
-            if(newValue.length()>0){
-                if(_state != ESPEasyCfgState::Connected){
-                    msg +=  "You will be disconnected from AP.";
-                    action |= ESPEasyCfgAbstractParameter::CLOSE;
-                }else{
-                    msg +=  "Trying to connect to ";
-                    msg += newValue;
-                }
-            }
-            setState(ESPEasyCfgState::WillConnect);
+            reconnectTo(newValue, msg, action);
         }
         return false;
     });
+    for(uint8_t i=0;i<(ESPEASYCFG_MAX_NETWORKS-1);++i){
+        ESPEasyCfgNetwork* net = &_networks[i];
+        net->getSSIDParameter()->setValidator([this](ESPEasyCfgParameter<String> *param, String newValue, String &msg, int8_t& action) -> bool{
+            if(newValue != param->getValue()){
+                reconnectTo(newValue, msg, action);
+            }
+            return false;
+        });
+        net->getPassParameter()->setValidator([this, net](ESPEasyCfgParameter<String> *param, String newValue, String &msg, int8_t& action) -> bool{
+            if((newValue != param->getValue()) && (net->getSSID().length()>0)){
+                reconnectTo(net->getSSID(), msg, action);
+            }
+            return false;
+        });
+    }
+    _staticIP.setValidator([this](ESPEasyCfgParameter<String> *param, String newValue, String &msg, int8_t& action) -> bool{
+        return validateAddress(param, newValue, msg, false);
+    });
+    _staticMask.setValidator([this](ESPEasyCfgParameter<String> *param, String newValue, String &msg, int8_t& action) -> bool{
+        return validateAddress(param, newValue, msg, true);
+    });
+    _staticGateway.setValidator([this](ESPEasyCfgParameter<String> *param, String newValue, String &msg, int8_t& action) -> bool{
+        return validateAddress(param, newValue, msg, false);
+    });
+    _staticDNS.setValidator([this](ESPEasyCfgParameter<String> *param, String newValue, String &msg, int8_t& action) -> bool{
+        return validateAddress(param, newValue, msg, false);
+    });
 
     //Parameter handler. Default to ESPEasyCfgParameterManagerJSON if not specified
     infoMessage("Open portal configuration");
@@ -172,11 +516,45 @@ void ESPEasyCfg::begin()
     _paramManager->init(&_paramGrp);
     //Load parameters from file
     _paramManager->loadParameters(&_paramGrp, CFG_VERSION);
+    //Loaded values are the committed ones
+    commitParameters();
 
     //Install HTTP handlers
     //Register static files stored into flash (Libraries (JQuery, Bootstrap) and config page)
     infoMessage("Regitering portal web pages");
     _fileHandler = registerStaticFiles(_webServer);
+    //Pages need a session, assets are public to be cached by browsers
+    _fileHandler->addMiddleware([this](AsyncWebServerRequest *request, ArMiddlewareNext next){
+        if(_authRequired && !isAuthorized(request))
+            return request->redirect(F("/login"));
+        next();
+    });
+    //Login form, giving a session cookie
+    _webServer->on("/login", HTTP_GET, [this](AsyncWebServerRequest *request){
+        sendLoginPage(request, false);
+    });
+    _webServer->on("/login", HTTP_POST, [this](AsyncWebServerRequest *request){
+        //Always rate limited, against password guessing
+        if(!_admission.admit(request, ESPEasyCfgEndpoint::Login, true))
+            return;
+        PARAM_LOCK();
+        const AsyncWebParameter* password = request->getParam("password", true);
+        String iotPass = _iotPass.getValue();
+        if((iotPass.length() > 0) &&
+            ((password == nullptr) || !ESPEasyCfgSession::equals(password->value().c_str(), iotPass.c_str()))){
+            return sendLoginPage(request, true);
+        }
+        char token[ESPEASYCFG_SESSION_TOKEN_LEN + 1];
+        _session.createToken(token);
+        char cookie[ESPEASYCFG_SESSION_TOKEN_LEN + 80];
+        snprintf(cookie, sizeof(cookie), ESPEASYCFG_SESSION_COOKIE "=%s; Path=/; Max-Age=%lu; HttpOnly; SameSite=Strict",
+                    token, (unsigned long)_session.getTimeout());
+        AsyncWebServerResponse *response = request->beginResponse(303);
+        response->addHeader("Location", "/www/config.html");
+        response->addHeader("Set-Cookie", cookie);
+        response->addHeader("Cache-Control", "no-store");
+        request->send(response);
+    });
     //Root handling
     _webServer->on("/", HTTP_GET, [this](AsyncWebServerRequest *request){
         if(_state == ESPEasyCfgState::AP){
@@ -187,8 +565,8 @@ void ESPEasyCfg::begin()
         }else{
             if(!_rootHandler){
                 //No root handler installed, fall back to our configuration page
-                if((_iotPass.getValue().length()>0) && !request->authenticate("admin", _iotPass.getValue().c_str()))
-                    return request->requestAuthentication(_iotName.getValue().c_str());
+                if(!isAuthorized(request))
+                    return request->redirect(F("/login"));
                 request->redirect(F("/www/config.html"));
             }else{
                 _rootHandler(request);
@@ -196,20 +574,125 @@ void ESPEasyCfg::begin()
         }
     });
 
-    //Gets the device configuration as JSON document
+    //Exports the persisted configuration, streamed (before /config, which matches it too)
+    _webServer->on("/config/export", HTTP_GET, [this](AsyncWebServerRequest *request){
+        if(!_admission.admit(request, ESPEasyCfgEndpoint::Config, _state == ESPEasyCfgState::AP))
+            return;
+        //Authorized client needed once a password is set, even in AP mode
+        bool secrets = request->hasParam("secrets") && request->getParam("secrets")->value().equals("1");
+        if(!isAuthorized(request))
+            return request->send(401, "text/plain", "Login required");
+        PARAM_LOCK();
+        if(secrets && (_iotPass.getValue().length() == 0))
+            return request->send(403, "text/plain", "Set a password to export secrets");
+        std::shared_ptr<ESPEasyCfgExporter> exporter = std::make_shared<ESPEasyCfgExporter>(&_paramGrp, CFG_VERSION, secrets);
+        AsyncWebServerResponse *response = request->beginChunkedResponse("application/json",
+            [this, exporter](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+                PARAM_LOCK();
+                return exporter->read(buffer, maxLen);
+            });
+        //Device name is user input, only safe characters are kept in the header
+        String name = _iotName.getValue();
+        for(size_t i=0;i<name.length();++i){
+            char c = name[i];
+            if(!isalnum((unsigned char)c) && (c != '.') && (c != '_') && (c != '-')){
+                name.setCharAt(i, '_');
+            }
+        }
+        String disposition = "attachment; filename=\"";
+        disposition += name;
+        disposition += ".json\"";
+        response->addHeader("Content-Disposition", disposition);
+        response->addHeader("Cache-Control", "no-store");
+        request->send(response);
+    });
+
+    //Imports a whole configuration, parsed as it is received
+    _webServer->on("/config/import", HTTP_POST, [this](AsyncWebServerRequest *request){
+        finishImport(request);
+    }, nullptr, [this](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total){
+        if(index == 0){
+            //Checked before allocating the importer, body of rejected requests is dropped
+            if((_state != ESPEasyCfgState::AP) && !isAuthorized(request))
+                return;
+            uint32_t retryAfter = 0;
+            int code = _admission.acquire(request, ESPEasyCfgEndpoint::Import, _state == ESPEasyCfgState::AP, retryAfter);
+            if((code == 0) && (_importer != nullptr)){
+                //Only one import at a time, even if the limit is raised
+                _admission.release(ESPEasyCfgEndpoint::Import);
+                code = 503;
+                retryAfter = 2;
+            }
+            if(code != 0){
+                //Answered once the body is received, freed with the request
+                ImportRejection* rejection = (ImportRejection*)malloc(sizeof(ImportRejection));
+                if(rejection != nullptr){
+                    rejection->code = code;
+                    rejection->retryAfter = retryAfter;
+                    request->_tempObject = rejection;
+                }
+                return;
+            }
+            _importer = new ESPEasyCfgImporter(&_paramGrp);
+            _importRequest = request;
+            request->onDisconnect([this, request](){
+                _admission.release(ESPEasyCfgEndpoint::Import);
+                if(_importRequest == request){
+                    delete _importer;
+                    _importer = nullptr;
+                    _importRequest = nullptr;
+                }
+            });
+        }
+        if(_importRequest == request){
+            _importer->write(data, len);
+        }
+    });
+
+    //Gets the device configuration as JSON document (all groups, one group, index or infos)
     _webServer->on("/config", HTTP_GET, [this](AsyncWebServerRequest *request){
-        if((_state != ESPEasyCfgState::AP) && (_iotPass.getValue().length()>0) && !request->authenticate("admin", _iotPass.getValue().c_str()))
-            return request->requestAuthentication(_iotName.getValue().c_str());
+        if(!_admission.admit(request, ESPEasyCfgEndpoint::Config, _state == ESPEasyCfgState::AP))
+            return;
+        if((_state != ESPEasyCfgState::AP) && !isAuthorized(request))
+            return request->send(401, "text/plain", "Login required");
+        PARAM_LOCK();
+        //Group requested with ?group=N
+        ESPEasyCfgParameterGroup* grp = nullptr;
+        long index = -1;
+        if(request->hasParam("group")){
+            index = request->getParam("group")->value().toInt();
+            grp = &_paramGrp;
+            for(long i=0;(i<index) && (grp != nullptr);++i){
+                grp = grp->getNext();
+            }
+            if((index < 0) || (grp == nullptr)){
+                return request->send(404, "text/plain", "Unknown group");
+            }
+        }
         AsyncJsonResponse * response = new AsyncJsonResponse(false);
-        response->addHeader("Server","ESP Async Web Server");
-        response->addHeader("Access-Control-Allow-Origin", "*");
         JsonObject root = response->getRoot().as<JsonObject>();
-        JsonArray infoArr = root["infos"].to<JsonArray>();
-        addInfosToJSON(infoArr);
-        JsonArray arr = root["groups"].to<JsonArray>();
-        toJSON(arr, &_paramGrp);
-        response->setLength();
-        request->send(response);
+        //Also serves /config/index and /config/infos, for lazy loading of the page
+        const String& url = request->url();
+        if(url.equals("/config/index")){
+            //Only names of the groups
+            JsonArray arr = root["groups"].to<JsonArray>();
+            indexToJSON(arr);
+        }else if(url.equals("/config/infos")){
+            JsonArray infoArr = root["infos"].to<JsonArray>();
+            addInfosToJSON(infoArr);
+        }else if(grp != nullptr){
+            //Parameters of a single group
+            JsonArray arr = root["groups"].to<JsonArray>();
+            groupToJSON(arr, grp);
+            root["index"] = index;
+        }else{
+            JsonArray infoArr = root["infos"].to<JsonArray>();
+            addInfosToJSON(infoArr);
+            JsonArray arr = root["groups"].to<JsonArray>();
+            toJSON(arr, &_paramGrp);
+        }
+        root["generation"] = _configGeneration;
+        sendJSON(request, response);
         if(_state == ESPEasyCfgState::AP){
             _lastApUsage = millis();
         }
@@ -217,16 +700,18 @@ void ESPEasyCfg::begin()
 
     //Handler to receive new configuration
     _cfgHandler = new AsyncCallbackJsonWebHandler("/configPost", [this](AsyncWebServerRequest *request, JsonVariant &json){
-        if((_state != ESPEasyCfgState::AP) && (_iotPass.getValue().length()>0) && !request->authenticate("admin", _iotPass.getValue().c_str()))
-            return request->requestAuthentication(_iotName.getValue().c_str());
+        if(!_admission.admit(request, ESPEasyCfgEndpoint::ConfigPost, _state == ESPEasyCfgState::AP))
+            return;
+        if((_state != ESPEasyCfgState::AP) && !isAuthorized(request))
+            return request->send(401, "text/plain", "Login required");
+        PARAM_LOCK();
         JsonObject jsonObj = json.as<JsonObject>();
         String str;
-        int8_t action;
-        fromJSON(jsonObj, &_paramGrp, str, action);
+        int8_t action = 0;
+        bool persistedChanged = false;
+        uint32_t generation = applyConfiguration(jsonObj, str, action, persistedChanged);
 
         AsyncJsonResponse * response = new AsyncJsonResponse(false);
-        response->addHeader("Server","ESP Async Web Server");
-        response->addHeader("Access-Control-Allow-Origin", "*");
         JsonObject root = response->getRoot().as<JsonObject>();
         JsonArray arr = root["groups"].to<JsonArray>();
         toJSON(arr, &_paramGrp);
@@ -236,60 +721,95 @@ void ESPEasyCfg::begin()
         if(action != 0){
             root["action"] = action;
         }
-        response->setLength();
-        request->send(response);
-        saveParameters();
-        if(_stateHandler){
-            _stateHandler(ESPEasyCfgState::Reconfigured);
-        }
+        root["generation"] = generation;
+        sendJSON(request, response);
+        //?apply=1 only stores parameters which are always persisted
+        commitConfiguration(!request->hasParam("apply"), persistedChanged);
+    });
+    _webServer->addHandler(_cfgHandler);
+
+    //Events pushed to the configuration page
+    _events = new AsyncEventSource("/events");
+    _events->addMiddleware([this](AsyncWebServerRequest *request, ArMiddlewareNext next){
+        if(_authRequired && !isAuthorized(request))
+            return request->send(401, "text/plain", "Login required");
+        next();
+    });
+    _events->onConnect([this](AsyncEventSourceClient *client){
+        //Initial state of the new client
+        client->send(state_names[static_cast<int>(_state)], "state");
         if(_state == ESPEasyCfgState::AP){
             _lastApUsage = millis();
         }
     });
-    _webServer->addHandler(_cfgHandler);
+    _webServer->addHandler(_events);
 
 
     //Handler to scan networks
     _webServer->on("/scan", HTTP_GET, [this](AsyncWebServerRequest *request){
-        if((_state != ESPEasyCfgState::AP) && (_iotPass.getValue().length()>0) && !request->authenticate("admin", _iotPass.getValue().c_str()))
-            return request->requestAuthentication(_iotName.getValue().c_str());
+        if(!_admission.admit(request, ESPEasyCfgEndpoint::Scan, _state == ESPEasyCfgState::AP))
+            return;
+        if((_state != ESPEasyCfgState::AP) && !isAuthorized(request))
+            return request->send(401, "text/plain", "Login required");
+        if(_state == ESPEasyCfgState::AP){
+            _lastApUsage = millis();
+        }
+        //Results of reconnection probes only list our networks
+        bool filtered = _scanner.isFiltered();
+        if(filtered || (_scanner.getAge() > SCAN_MAX_AGE)){
+            _scanner.request();
+            wakeUp();
+        }
+        //Served from the scan service cache
+        ESPEasyCfgScanResult results[ESPEASYCFG_SCAN_MAX];
+        uint32_t generation;
+        unsigned long age;
+        uint8_t n = _scanner.snapshot(results, generation, age);
+        bool valid = (generation != 0) && !filtered;
+        char etag[24];
+        snprintf(etag, sizeof(etag), "\"scan-%lu\"", (unsigned long)generation);
+        if(valid && matchesETag(request, etag)){
+            AsyncWebServerResponse * notModified = new AsyncBasicResponse(304);
+            notModified->addHeader("ETag", etag);
+            notModified->addHeader("Cache-Control", "no-cache");
+            request->send(notModified);
+            return;
+        }
         AsyncJsonResponse * response = new AsyncJsonResponse(false);
-        response->addHeader("Server","ESP Async Web Server");
-        response->addHeader("Access-Control-Allow-Origin", "*");
-        response->addHeader("Cache-Control", "max-age=10");
         JsonObject root = response->getRoot().as<JsonObject>();
         JsonArray arr = root["networks"].to<JsonArray>();
-        int n = WiFi.scanComplete();
-        if(n == -2){
-            this->scanNetworks();
-        }
-        root["count"] = n;
-        for (int i = 0; i < n; ++i) {
-            JsonObject network = arr.add<JsonObject>();
-            network["SSID"] = WiFi.SSID(i);
-            network["RSSI"] = WiFi.RSSI(i);
-            network["open"] = (WiFi.encryptionType(i) == WIFI_AUTH_OPEN);
-            network["channel"] = WiFi.channel(i);
-        }
-        response->setLength();
-        request->send(response);
-        if(_state == ESPEasyCfgState::AP){
-            _lastApUsage = millis();
+        //Count is negative while no result is available
+        root["count"] = valid ? n : -1;
+        root["scanning"] = _scanner.isRunning();
+        //Last scan failed, results (if any) are from an older one
+        root["failed"] = _scanner.hasFailed();
+        if(valid){
+            root["age"] = age / 1000;
+            for (uint8_t i = 0; i < n; ++i) {
+                JsonObject network = arr.add<JsonObject>();
+                network["SSID"] = results[i].ssid;
+                network["RSSI"] = results[i].rssi;
+                network["open"] = results[i].open;
+                network["channel"] = results[i].channel;
+            }
         }
+        sendJSON(request, response, "no-cache", valid ? etag : nullptr);
+    });
+    //OS connectivity checks, only handled in AP mode
+    _webServer->addHandler(new CaptiveProbeHandler([this](AsyncWebServerRequest *request){
+        sendPortalRedirect(request);
+    })).setFilter([this](AsyncWebServerRequest *request){
+        return _state == ESPEasyCfgState::AP;
     });
     _webServer->onNotFound([this](AsyncWebServerRequest * request){
         if(_state == ESPEasyCfgState::AP){
-            _lastApUsage = millis();
             DebugPrint("Requested :" );
             DebugPrintln(request->host());
-            if(!request->host().startsWith(_iotName.getValue()) ||
-                !request->host().startsWith(WiFi.softAPIP().toString())){
-                String loc = "http://";
-                loc += WiFi.softAPIP().toString();
-                request->redirect(loc);
-                DebugPrint("Redirected to :" );
-                DebugPrintln(loc);
+            if(!request->host().startsWith(_iotName.getValue()) &&
+                !request->host().startsWith(_portalHost)){
+                sendPortalRedirect(request);
             }else{
+                _lastApUsage = millis();
                 request->send(404, "text/plain", "Not found");
             }
         }else{
@@ -303,42 +823,111 @@ void ESPEasyCfg::begin()
         }
     });
 
+    //Wake up the state machine on WiFi events instead of polling
+#ifdef ESP32
+    _wifiEventId = WiFi.onEvent([this](arduino_event_id_t event, arduino_event_info_t info){
+        wakeUp();
+    });
+#else
+    _gotIpHandler = WiFi.onStationModeGotIP([this](const WiFiEventStationModeGotIP& event){
+        wakeUp();
+    });
+    _disconnectedHandler = WiFi.onStationModeDisconnected([this](const WiFiEventStationModeDisconnected& event){
+        wakeUp();
+    });
+#endif
+
+    //Reconnection is driven by the backoff policy, not by the WiFi stack
+    WiFi.setAutoReconnect(false);
+    applyPowerMode();
     //Connect to WiFi
-    if(_wifiSSID.getValue().length()>0){
-        //Configuration already done, we must switch to AP mode and start
+    if(getFirstNetwork() < ESPEASYCFG_MAX_NETWORKS){
+        //Configuration already done, connection is started by the state machine
+        //No scan here, it would delay the connection
         WiFi.begin();
         delay(50);
-        scanNetworks();
     }else{
         //Not configured, switch to AP mode
         switchToAP();
     }
 #ifdef ESP32
+    //Call handlers from their own task, so they cannot stall the portal
+    if(_eventTaskEnabled){
+        xTaskCreatePinnedToCore(ESPEasyCfgEventTask,
+                    "CfgEvents",
+                    EVENT_TASK_STACK,
+                    this,
+                    _eventTaskPriority,
+                    &_eventTask,
+                    _eventTaskCore);
+    }
     //Monitor the connection state using a dedicated FreeRTOS task
     xTaskCreate(ESPEasyCfgMonitorTask,   /* Task function. */
                     "ConMonitor",        /* String with name of task. */
-                    4096,                /* Stack size in bytes. */
+                    MONITOR_TASK_STACK,  /* Stack size in bytes (validators and saves of serial provisioning). */
                     this,                /* Parameter passed as input of the task */
                     0,                   /* Priority of the task. */
-                    NULL);               /* Task handle. */
+                    &_monitorTask);      /* Task handle. */
 #endif
+    //Session key drawn once the radio is on, for a better entropy
+    {
+        PARAM_LOCK();
+        _session.renew();
+    }
     infoMessage("Portal configured!");
 }
 
+void ESPEasyCfg::sendJSON(AsyncWebServerRequest *request, AsyncJsonResponse* response, const char* cacheControl,
+                            const char* etag)
+{
+    auto addHeaders = [cacheControl, etag](AsyncWebServerResponse* resp){
+        resp->addHeader("Server","ESP Async Web Server");
+        resp->addHeader("Access-Control-Allow-Origin", "*");
+        if(cacheControl){
+            resp->addHeader("Cache-Control", cacheControl);
+        }
+        if(etag){
+            resp->addHeader("ETag", etag);
+        }
+    };
+    size_t len = response->setLength();
+    if((_jsonGzipThreshold == 0) || (len < _jsonGzipThreshold)){
+        addHeaders(response);
+        request->send(response);
+        return;
+    }
+    if(!acceptsEncoding(request, "gzip")){
+        addHeaders(response);
+        response->addHeader("Vary", "Accept-Encoding");
+        request->send(response);
+        return;
+    }
+    //Large document, compressed as the socket drains
+    std::shared_ptr<GzipJsonFiller> filler = std::make_shared<GzipJsonFiller>(response, len);
+    AsyncWebServerResponse* chunked = request->beginChunkedResponse("application/json",
+        [filler](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+            return filler->read(buffer, maxLen);
+        });
+    addHeaders(chunked);
+    chunked->addHeader("Vary", "Accept-Encoding");
+    chunked->addHeader("Content-Encoding", "gzip");
+    request->send(chunked);
+}
+
 ESPEasyCfgState ESPEasyCfg::getState()
 {
     return _state;
 }
 
-void ESPEasyCfg::runDNS()
+void ESPEasyCfg::startDNS()
 {
     //Instantiate/start DNS server if not running
     if(_dnsServer == nullptr){
-        _dnsServer = new DNSServer();
-        _dnsServer->setErrorReplyCode(DNSReplyCode::NoError);
-        _dnsServer->start(53, "*", WiFi.softAPIP());
+        _dnsServer = new ESPEasyCfgDNSServer();
+        if(!_dnsServer->start(WiFi.softAPIP())){
+            DebugPrintln("Unable to start DNS server");
+        }
     }
-    _dnsServer->processNextRequest();
 }
 
 void ESPEasyCfg::stopDNS()
@@ -364,7 +953,7 @@ void ESPEasyCfg::switchToAP()
     _lastApUsage = millis();
     //Scan networks before switching to AP mode
     DebugPrintln("Switching to AP mode");
-    scanNetworks();
+    _scanner.start();
 #ifdef ESP32
     WiFi.mode(WIFI_AP_STA);
 #else
@@ -378,142 +967,645 @@ void ESPEasyCfg::switchToAP()
         //Open AP (factory or lazy)
         WiFi.softAP(_iotName.getValue().c_str());
     }
-    _fileHandler->setAuthentication("", "");
+    setHandlersAuthentication(false);
     delay(100);
     DebugPrint("AP IP ");
     DebugPrintln(WiFi.softAPIP());
+    //Captive portal redirection, built once
+    _portalHost = WiFi.softAPIP().toString();
+    _portalURL = "http://";
+    _portalURL += _portalHost;
+    _portalURL += "/";
+    _portalBody = "<!DOCTYPE html><html><body><a href=\"";
+    _portalBody += _portalURL;
+    _portalBody += "\">Configuration portal</a></body></html>";
     setState(ESPEasyCfgState::AP);
 }
 
+void ESPEasyCfg::sendPortalRedirect(AsyncWebServerRequest *request)
+{
+    _lastApUsage = millis();
+    AsyncWebServerResponse *response = request->beginResponse(302, "text/html", _portalBody);
+    response->addHeader("Location", _portalURL);
+    response->addHeader("Cache-Control", "no-store");
+    request->send(response);
+}
+
 void ESPEasyCfg::switchToSTA()
 {
     stopDNS();
-    DebugPrint("Trying to connect to ");
-    DebugPrintln(_wifiSSID.getValue());
     WiFi.mode(WIFI_STA);
-    if(_wifiPass.getValue().length()>0){
-        WiFi.begin(_wifiSSID.getValue().c_str(), _wifiPass.getValue().c_str());
+    _probed = false;
+    _candidateCount = 0;
+    _candidateIndex = 0;
+    setState(ESPEasyCfgState::Connecting);
+    if(_fastReconnect){
+        for(uint8_t n=0;n<ESPEASYCFG_MAX_NETWORKS;++n){
+            String ssid = getNetworkSSID(n);
+            if((ssid.length()>0) && _conCache.load(ssid, getNetworkPass(n))){
+                //Directed connection to previous access point
+                DebugPrintln("Using cached connection");
+                _network = n;
+                configureIP();
+                beginSTA(n, _conCache.getChannel(), _conCache.getBSSID());
+                setConnectPhase(ConnectPhase::Direct);
+                return;
+            }
+        }
+    }
+    //Look for our networks instead of letting connection scan all channels
+    startProbe();
+}
+
+void ESPEasyCfg::setConnectPhase(ConnectPhase phase)
+{
+    _connectPhase = phase;
+    _phaseStart = millis();
+}
+
+void ESPEasyCfg::startProbe(uint8_t channel)
+{
+    _probed = true;
+    _probeChannel = channel;
+    setConnectPhase(ConnectPhase::Probing);
+    if(!_scanner.isFiltered() && (_scanner.getAge() < SCAN_REUSE_TIME)){
+        //Recent scan result available, no need to scan again
+        DebugPrintln("Using last scan result");
+        connectFromProbe();
+        return;
+    }
+    DebugPrintln("Probing for networks");
+    //Scan can be restricted to one SSID if only one network is known
+    String ssid;
+    uint8_t count = 0;
+    for(uint8_t n=0;n<ESPEASYCFG_MAX_NETWORKS;++n){
+        if(getNetworkSSID(n).length()>0){
+            ssid = getNetworkSSID(n);
+            ++count;
+        }
+    }
+    //Short dwell time per channel, a running scan is awaited
+    _probeScanCount = _scanner.getScanCount();
+    _scanner.start((count == 1) ? ssid.c_str() : nullptr, hasHiddenNetwork(), PROBE_DWELL_TIME, channel);
+}
+
+bool ESPEasyCfg::hasHiddenNetwork()
+{
+    if(_scanner.isFiltered() || (_scanner.getGeneration() == 0)){
+        return false;
+    }
+    for(uint8_t n=0;n<ESPEASYCFG_MAX_NETWORKS;++n){
+        String ssid = getNetworkSSID(n);
+        if((ssid.length()>0) && (_scanner.find(ssid) == nullptr)){
+            return true;
+        }
+    }
+    return false;
+}
+
+void ESPEasyCfg::connectFromProbe()
+{
+    _candidateCount = 0;
+    _candidateIndex = 0;
+    //Scan results hold the strongest access point of each network
+    for(uint8_t net=0;net<ESPEASYCFG_MAX_NETWORKS;++net){
+        String ssid = getNetworkSSID(net);
+        const ESPEasyCfgScanResult* found = (ssid.length() > 0) ? _scanner.find(ssid) : nullptr;
+        if(found != nullptr){
+            Candidate& c = _candidates[_candidateCount++];
+            c.network = net;
+            memcpy(c.bssid, found->bssid, sizeof(c.bssid));
+            c.channel = found->channel;
+            c.rssi = found->rssi;
+        }
+    }
+    //Sort by priority, then by signal strength
+    for(uint8_t i=1;i<_candidateCount;++i){
+        Candidate c = _candidates[i];
+        uint16_t prio = getNetworkPriority(c.network);
+        int8_t j = i - 1;
+        while((j >= 0) && ((getNetworkPriority(_candidates[j].network) < prio) ||
+                ((getNetworkPriority(_candidates[j].network) == prio) && (_candidates[j].rssi < c.rssi)))){
+            _candidates[j+1] = _candidates[j];
+            --j;
+        }
+        _candidates[j+1] = c;
+    }
+    DebugPrint("Known networks found : ");
+    DebugPrintln(_candidateCount);
+    if((_candidateCount == 0) && (_probeChannel != 0)){
+        //Not on the channel of the last connection, look at all channels
+        startProbe(0);
+        return;
+    }
+    connectNextCandidate();
+}
+
+void ESPEasyCfg::connectNextCandidate()
+{
+    configureIP();
+    if(_candidateIndex < _candidateCount){
+        const Candidate& c = _candidates[_candidateIndex++];
+        _network = c.network;
+        DebugPrint("Network found on channel ");
+        DebugPrintln(c.channel);
+        beginSTA(c.network, c.channel, c.bssid);
+        setConnectPhase(ConnectPhase::Direct);
     }else{
-        WiFi.begin(_wifiSSID.getValue().c_str());
+        //Last resort, let the WiFi stack search for the first network
+        DebugPrintln("No more network to try");
+        _network = getFirstNetwork();
+        beginSTA(_network, 0, nullptr);
+        setConnectPhase(ConnectPhase::Full);
+    }
+}
+
+String ESPEasyCfg::getNetworkSSID(uint8_t network)
+{
+    if(network == 0){
+        return _wifiSSID.getValue();
+    }else if(network < ESPEASYCFG_MAX_NETWORKS){
+        return _networks[network-1].getSSID();
+    }
+    return String();
+}
+
+String ESPEasyCfg::getNetworkPass(uint8_t network)
+{
+    if(network == 0){
+        return _wifiPass.getValue();
+    }else if(network < ESPEASYCFG_MAX_NETWORKS){
+        return _networks[network-1].getPass();
+    }
+    return String();
+}
+
+uint16_t ESPEasyCfg::getNetworkPriority(uint8_t network)
+{
+    if(network == 0){
+        return _wifiPriority.getValue();
+    }else if(network < ESPEASYCFG_MAX_NETWORKS){
+        return _networks[network-1].getPriority();
+    }
+    return 0;
+}
+
+uint8_t ESPEasyCfg::getFirstNetwork()
+{
+    uint8_t n = 0;
+    while((n < ESPEASYCFG_MAX_NETWORKS) && (getNetworkSSID(n).length() == 0)){
+        ++n;
+    }
+    return n;
+}
+
+unsigned long ESPEasyCfg::processRoaming(unsigned long now)
+{
+    if(_roamScanning){
+        if(_scanner.getScanCount() == _roamScanCount){
+            //Still scanning
+            return SCAN_POLL_TIME;
+        }
+        _roamScanning = false;
+        //Scan results hold the strongest access point of the network
+        //Those of a failed scan are older ones, retried at next roaming scan
+        const ESPEasyCfgScanResult* best = _scanner.hasFailed() ? nullptr : _scanner.find(WiFi.SSID());
+        const uint8_t* current = WiFi.BSSID();
+        if((best != nullptr) && (current != nullptr) && (memcmp(best->bssid, current, sizeof(best->bssid)) != 0) &&
+            (best->rssi >= (_rssiAvg + _roamHysteresis))){
+            DebugPrint("Roaming to access point with RSSI ");
+            DebugPrintln(best->rssi);
+            //Reconnect using the connection state machine
+            _candidates[0].network = _network;
+            memcpy(_candidates[0].bssid, best->bssid, sizeof(_candidates[0].bssid));
+            _candidates[0].channel = best->channel;
+            _candidates[0].rssi = best->rssi;
+            _candidateCount = 1;
+            _candidateIndex = 0;
+            _probed = true;
+            WiFi.disconnect();
+            _connectStart = now;
+            _connTimeout = _backoff->getConnectTimeout();
+            setState(ESPEasyCfgState::Connecting);
+            connectNextCandidate();
+            return 0;
+        }
+    }
+    if((now-_lastRssiSample) >= ROAM_SAMPLE_TIME){
+        //Exponential moving average, smoothing short fades
+        _lastRssiSample = now;
+        _rssiAvg = (_rssiAvg * 3 + WiFi.RSSI()) / 4;
+        if((_rssiAvg < _roamThreshold) && ((now-_lastRoamScan) >= ROAM_SCAN_INTERVAL) &&
+            !_scanner.isRunning()){
+            //Weak signal, look for other access points of this network
+            DebugPrint("Weak signal, RSSI ");
+            DebugPrintln(_rssiAvg);
+            String ssid = WiFi.SSID();
+            _lastRoamScan = now;
+            _roamScanCount = _scanner.getScanCount();
+            _roamScanning = _scanner.start(ssid.c_str(), false, PROBE_DWELL_TIME);
+            return SCAN_POLL_TIME;
+        }
+    }
+    return ROAM_SAMPLE_TIME - (now-_lastRssiSample) + 1;
+}
+
+void ESPEasyCfg::configureIP()
+{
+    IPAddress ip, mask, gateway, dns;
+    if(ip.fromString(_staticIP.getValue()) && mask.fromString(_staticMask.getValue()) &&
+        gateway.fromString(_staticGateway.getValue())){
+        if(!dns.fromString(_staticDNS.getValue())){
+            dns = gateway;
+        }
+        DebugPrint("Using static IP ");
+        DebugPrintln(ip);
+        WiFi.config(ip, gateway, mask, dns);
+    }else{
+        //Null address enables DHCP
+        WiFi.config(IPAddress((uint32_t)0), IPAddress((uint32_t)0), IPAddress((uint32_t)0));
+    }
+}
+
+bool ESPEasyCfg::validateAddress(ESPEasyCfgParameter<String> *param, const String& newValue, String& msg, bool isMask)
+{
+    if(newValue.length() == 0){
+        return false;
+    }
+    IPAddress addr;
+    bool valid = addr.fromString(newValue);
+    if(valid && isMask){
+        //Mask bits must be contiguous
+        uint32_t m = ((uint32_t)addr[0] << 24) | ((uint32_t)addr[1] << 16) | ((uint32_t)addr[2] << 8) | addr[3];
+        uint32_t inv = ~m;
+        valid = (m != 0) && ((inv & (inv + 1)) == 0);
+    }
+    if(!valid){
+        msg += "Invalid ";
+        msg += param->getName();
+        msg += " : ";
+        msg += newValue;
+        msg += ". ";
+        return true;
+    }
+    return false;
+}
+
+bool ESPEasyCfg::validateStaticIP(String& msg)
+{
+    if(_staticIP.getValue().length() == 0){
+        return true;
+    }
+    IPAddress mask, gateway;
+    if(mask.fromString(_staticMask.getValue()) && gateway.fromString(_staticGateway.getValue())){
+        return true;
+    }
+    //configureIP() would silently fall back to DHCP
+    msg += "A static IP address needs a subnet mask and a gateway. IP configuration unchanged. ";
+    return false;
+}
+
+void ESPEasyCfg::beginSTA(uint8_t network, int32_t channel, const uint8_t* bssid)
+{
+    String ssid = getNetworkSSID(network);
+    String pass = getNetworkPass(network);
+    DebugPrint("Trying to connect to ");
+    DebugPrintln(ssid);
+    if(pass.length()>0){
+        WiFi.begin(ssid.c_str(), pass.c_str(), channel, bssid);
+    }else{
+        WiFi.begin(ssid.c_str(), nullptr, channel, bssid);
     }
-    setState(ESPEasyCfgState::Connecting);
 }
 
 #ifdef ESP32
 void ESPEasyCfg::monitorState()
+{
+    while(true){
+        unsigned long wait = processState();
+        if(_serial != nullptr){
+            pollSerial();
+            //Without receive event, poll fast only while a command is being received
+            unsigned long poll = (_serialLen > 0) ? SERIAL_POLL_TIME : SERIAL_IDLE_POLL_TIME;
+            if(!_serialEvent && (wait > poll)){
+                wait = poll;
+            }
+        }
+        //Sleep until next deadline or until woken up by an event
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait));
+    }
+}
+
+void ESPEasyCfg::dispatchTask()
+{
+    while(true){
+        dispatchEvents();
+        //Sleep until an event is posted
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
+
+void ESPEasyCfg::setEventTask(bool enable, BaseType_t core, UBaseType_t priority)
+{
+    _eventTaskEnabled = enable;
+    _eventTaskCore = core;
+    _eventTaskPriority = priority;
+}
 #else
 void ESPEasyCfg::loop()
-#endif
 {
-    static unsigned long connectStart = 0;
-    static unsigned long lastLedChange = 0;
-    static unsigned long connTimeout = 60000;
-    unsigned long ledTimeOn = 500;
-    unsigned long ledTimeOff = 500;
-#ifdef ESPEasyCfg_SERIAL_DEBUG
-    static unsigned long lastPrint = 0;
+    dispatchEvents();
+    if(_serial != nullptr){
+        pollSerial();
+    }
+    unsigned long now = millis();
+    if(!_wakeUp && ((now - _lastRun) < _nextRun)){
+        return;
+    }
+    _wakeUp = false;
+    _lastRun = now;
+    _nextRun = processState();
+}
 #endif
-    static bool ledState = false;
+
+void ESPEasyCfg::wakeUp()
+{
 #ifdef ESP32
-    while(true){
-        delay(10);
+    if(_monitorTask != nullptr){
+        xTaskNotifyGive(_monitorTask);
+    }
+#else
+    _wakeUp = true;
 #endif
-        unsigned long now = millis();
-        switch(_state){
-            case ESPEasyCfgState::Connecting:
-            {
-                ledTimeOn = 50;
-                ledTimeOff = 50;
-                if(WiFi.status() == WL_CONNECTED){
-                    //Set authentication for files
-                    if(_iotPass.getValue().length()>0){
-                        _fileHandler->setAuthentication("admin", _iotPass.getValue().c_str());
-                    }else{
-                        _fileHandler->setAuthentication("", "");
-                    }
-                    DebugPrint("\nConnected, IP is ");
-                    DebugPrintln(WiFi.localIP());
-                    setState(ESPEasyCfgState::Connected);
-                }else if((now-connectStart)>connTimeout){
-                    DebugPrintln();
-                    DebugPrint("Connection timeout ");
-                    connectStart = now;
+}
+
+unsigned long ESPEasyCfg::processState()
+{
+    unsigned long ledTimeOn = 500;
+    unsigned long ledTimeOff = 500;
+    unsigned long wait = MONITOR_MAX_WAIT;
+    unsigned long now = millis();
+    _scanner.poll();
+    if(_scanner.getScanCount() != _scanEventCount){
+        //Scan finished, clients fetch new results or the failure
+        _scanEventCount = _scanner.getScanCount();
+        pushEvent("scan", String(_scanner.getGeneration()).c_str());
+    }
+    switch(_state){
+        case ESPEasyCfgState::Connecting:
+        {
+            ledTimeOn = 50;
+            ledTimeOff = 50;
+            if(WiFi.status() == WL_CONNECTED){
+                //Set authentication for files
+                setHandlersAuthentication(true);
+                DebugPrint("\nConnected, IP is ");
+                DebugPrintln(WiFi.localIP());
+                if(_fastReconnect){
+                    _conCache.save(getNetworkSSID(_network), getNetworkPass(_network));
+                }
+                _backoff->reset();
+                _rssiAvg = WiFi.RSSI();
+                _lastRssiSample = now;
+                _lastRoamScan = now;
+                _roamScanning = false;
+                setState(ESPEasyCfgState::Connected);
+            }else if((now-_connectStart)>_connTimeout){
+                DebugPrintln();
+                DebugPrint("Connection timeout ");
+                _connectStart = now;
+                WiFi.disconnect();
+                unsigned long retry = _backoff->nextDelay();
+                DebugPrint("next try in ");
+                DebugPrintln(retry);
+                if(retry < AP_MIN_TIME){
+                    //Too short to be useful as a portal
+                    scheduleConnect(retry);
+                }else{
+                    _retryDelay = retry;
                     switchToAP();
+                }
+            }else if((_connectPhase == ConnectPhase::Direct) && ((now-_phaseStart)>FAST_CONNECT_TIMEOUT)){
+                //Directed connection failed
+                DebugPrintln("Fast connection failed");
+                WiFi.disconnect();
+                if(_probed){
+                    connectNextCandidate();
+                }else{
+                    //Access point may still be on the same channel
+                    uint8_t channel = _conCache.getChannel();
+                    _conCache.invalidate();
+                    startProbe(channel);
+                }
+                wait = 0;
+            }else if((_connectPhase == ConnectPhase::Probing) &&
+                        ((_scanner.getScanCount() != _probeScanCount) || ((now-_phaseStart)>PROBE_TIMEOUT))){
+                connectFromProbe();
+                wait = 0;
+            }else{
 #ifdef ESPEasyCfg_SERIAL_DEBUG
-                }else if((now-lastPrint)>1000){
-                    lastPrint = now;
+                if((now-_lastPrint)>1000){
+                    _lastPrint = now;
                     DebugPrint('.');
-#endif
-                }else{
-                    if(_switchPin != UNUSED_PIN){
-                        if(digitalRead(_switchPin) == LOW){
-							//Switch pressed.
-							DebugPrintln("Reseting password");
-                            _iotPass.setValue("");
-                            switchToAP();
-                        }
-                    }
                 }
-                break;
-            }
-            case ESPEasyCfgState::WillConnect:
-            {
-                ledTimeOn = 500;
-                ledTimeOff = 500;
-                if(_wifiSSID.getValue().length()>0){
-                    connectStart = now;
-#ifdef ESP32
-                    //Wait to have time to send response
-                    delay(100);
 #endif
-                    switchToSTA();
-                }else{
-                    switchToAP();
+                if(_switchPin != UNUSED_PIN){
+                    if(digitalRead(_switchPin) == LOW){
+                        //Switch pressed.
+                        DebugPrintln("Reseting password");
+                        _iotPass.setValue("");
+                        _retryDelay = _backoff->nextDelay();
+                        switchToAP();
+                        break;
+                    }
+                    //Switch is polled while connecting
+                    wait = SWITCH_POLL_TIME;
                 }
-                break;
-            }
-            case ESPEasyCfgState::AP:
-            {
-                ledTimeOn = 100;
-                ledTimeOff = 100;
-                runDNS();
-                if(!_wifiSSID.getValue().isEmpty()){
-                    if((now-_lastApUsage)>AP_RECO_TIME){
-                        connTimeout = AP_RECO_TIMEOUT;
-                        DebugPrintln("Trying to reconnect");
-                        _state = ESPEasyCfgState::WillConnect;
+                //Wake up at timeout if connection events are not coming
+                unsigned long timeout = _connTimeout - (now-_connectStart) + 1;
+                if(_connectPhase == ConnectPhase::Direct){
+                    unsigned long phaseTimeout = FAST_CONNECT_TIMEOUT - (now-_phaseStart) + 1;
+                    if(phaseTimeout < timeout){
+                        timeout = phaseTimeout;
                     }
+                }else if((_connectPhase == ConnectPhase::Probing) && (SCAN_POLL_TIME < timeout)){
+                    timeout = SCAN_POLL_TIME;
                 }
-                break;
-            }
-            case ESPEasyCfgState::Connected:
-                ledTimeOn = 50;
-                ledTimeOff = 5000;
-                if(WiFi.status() != WL_CONNECTED){
-                    // Lost connection to AP, try to reconnect
-                    setState(ESPEasyCfgState::WillConnect);
+                if(timeout < wait){
+                    wait = timeout;
                 }
-                break;
-            default:
-                break;
-        }
-        //Led blinker
-        if(_ledPin != UNUSED_PIN){
-            if(ledState){
-                if((now-lastLedChange)>ledTimeOn){
-                    ledState = false;
-                    setLed(ledState);
-                    lastLedChange = now;
+            }
+            break;
+        }
+        case ESPEasyCfgState::WillConnect:
+        {
+            ledTimeOn = 500;
+            ledTimeOff = 500;
+            if(getFirstNetwork() < ESPEASYCFG_MAX_NETWORKS){
+                if((now-_retryStart) < _retryDelay){
+                    //Wait for the delay given by the backoff policy
+                    wait = _retryDelay - (now-_retryStart) + 1;
+                    break;
                 }
+                _connectStart = now;
+                _connTimeout = _backoff->getConnectTimeout();
+#ifdef ESP32
+                //Wait to have time to send response
+                delay(100);
+#endif
+                switchToSTA();
             }else{
-                if((now-lastLedChange)>ledTimeOff){
-                    ledState = true;
-                    setLed(ledState);
-                    lastLedChange = now;
+                switchToAP();
+            }
+            break;
+        }
+        case ESPEasyCfgState::AP:
+        {
+            ledTimeOn = 100;
+            ledTimeOff = 100;
+            //DNS queries are answered as they arrive
+            startDNS();
+            if(getFirstNetwork() < ESPEASYCFG_MAX_NETWORKS){
+                //Retry delay is extended while the portal is used
+                if((now-_lastApUsage)>_retryDelay){
+                    DebugPrintln("Trying to reconnect");
+                    _retryDelay = 0;
+                    _state = ESPEasyCfgState::WillConnect;
+                    applyPowerMode();
+                    pushEvent("state", state_names[static_cast<int>(_state)]);
+                    wait = 0;
+                }else if((_retryDelay - (now-_lastApUsage) + 1) < wait){
+                    //Wake up when retry delay is elapsed
+                    wait = _retryDelay - (now-_lastApUsage) + 1;
                 }
             }
+            break;
+        }
+        case ESPEasyCfgState::Connected:
+            ledTimeOn = 50;
+            ledTimeOff = 5000;
+            //Disconnection is signaled by WiFi events, status is checked as a safety net
+            if(WiFi.status() != WL_CONNECTED){
+                // Lost connection to AP, try to reconnect
+                DebugPrintln("Connection lost");
+                scheduleConnect(_backoff->lostDelay());
+            }else if(_roamThreshold != 0){
+                wait = processRoaming(now);
+            }
+            break;
+        default:
+            break;
+    }
+    //Scan completion is polled
+    if(_scanner.isRunning() && (SCAN_POLL_TIME < wait)){
+        wait = SCAN_POLL_TIME;
+    }
+    //Led blinker
+    if(_ledPin != UNUSED_PIN){
+        unsigned long period = _ledState ? ledTimeOn : ledTimeOff;
+        if((now-_lastLedChange)>period){
+            _ledState = !_ledState;
+            setLed(_ledState);
+            _lastLedChange = now;
+            period = _ledState ? ledTimeOn : ledTimeOff;
+        }
+        unsigned long ledWait = period - (now-_lastLedChange) + 1;
+        if(ledWait < wait){
+            wait = ledWait;
         }
+    }
+    return wait;
+}
+
+void ESPEasyCfg::scheduleConnect(unsigned long delay)
+{
+    _retryStart = millis();
+    _retryDelay = delay;
+    setState(ESPEasyCfgState::WillConnect);
+    wakeUp();
+}
+
+void ESPEasyCfg::reconnectTo(const String& ssid, String& msg, int8_t& action)
+{
+    if(ssid.length()>0){
+        if(_state != ESPEasyCfgState::Connected){
+            msg +=  "You will be disconnected from AP.";
+            action |= ESPEasyCfgAbstractParameter::CLOSE;
+        }else{
+            msg +=  "Trying to connect to ";
+            msg += ssid;
+        }
+    }
+    restartConnection();
+}
+
+void ESPEasyCfg::restartConnection()
+{
+    _backoff->reset();
+    scheduleConnect(0);
+}
+
+void ESPEasyCfg::setBackoffPolicy(ESPEasyCfgBackoffPolicy* policy)
+{
+    _backoff = (policy != nullptr) ? policy : &_defaultBackoff;
+}
+
+void ESPEasyCfg::setPowerMode(ESPEasyCfgPowerMode mode, uint8_t listenInterval)
+{
+    _powerMode = mode;
+    _listenInterval = listenInterval;
+    _powerModeApplied = false;
+    applyPowerMode();
+}
+
+void ESPEasyCfg::beginLowLatency()
+{
+    ++_lowLatency;
+    applyPowerMode();
+}
+
+void ESPEasyCfg::endLowLatency()
+{
+    if(_lowLatency > 0){
+        --_lowLatency;
+    }
+    applyPowerMode();
+}
+
+void ESPEasyCfg::applyPowerMode()
+{
+    ESPEasyCfgPowerMode mode = ESPEasyCfgPowerMode::None;
+    if((_state == ESPEasyCfgState::Connected) && (_lowLatency == 0)){
+        mode = _powerMode;
+    }
+    if(_powerModeApplied && (mode == _appliedPowerMode)){
+        return;
+    }
+    _appliedPowerMode = mode;
+    _powerModeApplied = true;
 #ifdef ESP32
+    switch(mode){
+        case ESPEasyCfgPowerMode::Modem:
+            WiFi.setSleep(WIFI_PS_MIN_MODEM);
+            break;
+        case ESPEasyCfgPowerMode::Light:
+            WiFi.setSleep(WIFI_PS_MAX_MODEM);
+            break;
+        default:
+            WiFi.setSleep(WIFI_PS_NONE);
+            break;
+    }
+#else
+    switch(mode){
+        case ESPEasyCfgPowerMode::Modem:
+            WiFi.setSleepMode(WIFI_MODEM_SLEEP);
+            break;
+        case ESPEasyCfgPowerMode::Light:
+            WiFi.setSleepMode(WIFI_LIGHT_SLEEP, _listenInterval);
+            break;
+        default:
+            WiFi.setSleepMode(WIFI_NONE_SLEEP);
+            break;
     }
 #endif
 }
@@ -522,9 +1614,11 @@ void ESPEasyCfg::setState(ESPEasyCfgState newState)
 {
     if(newState  != _state){
         _state = newState;
-        if(_stateHandler){
-            _stateHandler(_state);
-        }
+        ++_stateGeneration;
+        applyPowerMode();
+        wakeUp();
+        pushEvent("state", state_names[static_cast<int>(_state)]);
+        postState(_state);
     }
 }
 
@@ -539,39 +1633,422 @@ void ESPEasyCfg::setLed(bool state) {
 }
 
 void ESPEasyCfg::infoMessage(const char* msg) {
-    if(_msgHandler){
-        _msgHandler(msg, ESPEasyCfgMessageType::Info);
-    }
+    pushMessage(msg, "info");
+    postMessage(msg, ESPEasyCfgMessageType::Info);
 }
 
 void ESPEasyCfg::warningMessage(const char* msg) {
-    if(_msgHandler){
-        _msgHandler(msg, ESPEasyCfgMessageType::Warning);
-    }
+    pushMessage(msg, "warning");
+    postMessage(msg, ESPEasyCfgMessageType::Warning);
 }
 
 void ESPEasyCfg::errorMessage(const char* msg) {
-    if(_msgHandler){
-        _msgHandler(msg, ESPEasyCfgMessageType::Error);
+    pushMessage(msg, "error");
+    postMessage(msg, ESPEasyCfgMessageType::Error);
+}
+
+bool ESPEasyCfg::addStateHandler(StateHandlerFunction handler)
+{
+    for(uint8_t i=1;i<ESPEASYCFG_MAX_SUBSCRIBERS;++i){
+        if(!_stateHandlers[i]){
+            _stateHandlers[i] = handler;
+            return true;
+        }
     }
+    return false;
 }
 
+bool ESPEasyCfg::addMessageHandler(MessageHandlerFunction handler)
+{
+    for(uint8_t i=1;i<ESPEASYCFG_MAX_SUBSCRIBERS;++i){
+        if(!_msgHandlers[i]){
+            _msgHandlers[i] = handler;
+            return true;
+        }
+    }
+    return false;
+}
 
-void ESPEasyCfg::saveParameters() {
-    if(_paramManager)
-        _paramManager->saveParameters(&_paramGrp, CFG_VERSION);
+void ESPEasyCfg::postState(ESPEasyCfgState state)
+{
+    Event event;
+    event.isMessage = false;
+    event.state = state;
+    if(_eventQueue.push(event)){
+        notifyEvents();
+    }
 }
 
-void ESPEasyCfg::scanNetworks() {
-//Scan networks
-#ifdef ESP8266
-    WiFi.scanNetworks(true);
-#else
-    //To an async scan
-    WiFi.scanNetworks(true, false, false);
+void ESPEasyCfg::postMessage(const char* msg, ESPEasyCfgMessageType type)
+{
+    Event event;
+    event.isMessage = true;
+    event.msgType = type;
+    strncpy(event.msg, msg, sizeof(event.msg) - 1);
+    event.msg[sizeof(event.msg) - 1] = '\0';
+    if(_eventQueue.push(event)){
+        notifyEvents();
+    }
+}
+
+void ESPEasyCfg::notifyEvents()
+{
+#ifdef ESP32
+    if(_eventTask != nullptr){
+        xTaskNotifyGive(_eventTask);
+    }
 #endif
 }
 
+void ESPEasyCfg::callMessageHandlers(const char* msg, ESPEasyCfgMessageType type)
+{
+    for(uint8_t i=0;i<ESPEASYCFG_MAX_SUBSCRIBERS;++i){
+        if(_msgHandlers[i]){
+            _msgHandlers[i](msg, type);
+        }
+    }
+}
+
+void ESPEasyCfg::dispatchEvents()
+{
+    Event event;
+    while(_eventQueue.pop(event)){
+        if(event.isMessage){
+            callMessageHandlers(event.msg, event.msgType);
+        }else{
+            for(uint8_t i=0;i<ESPEASYCFG_MAX_SUBSCRIBERS;++i){
+                if(_stateHandlers[i]){
+                    _stateHandlers[i](event.state);
+                }
+            }
+        }
+    }
+    //Tell handlers that some events were lost
+    uint32_t dropped = _eventQueue.getDropped();
+    if(dropped != _reportedDrops){
+        char msg[48];
+        snprintf(msg, sizeof(msg), "%u portal events dropped", (unsigned int)(dropped - _reportedDrops));
+        _reportedDrops = dropped;
+        DebugPrintln(msg);
+        callMessageHandlers(msg, ESPEasyCfgMessageType::Warning);
+    }
+}
+
+void ESPEasyCfg::pushEvent(const char* event, const char* data)
+{
+    //Nothing to build if no client is listening
+    if((_events != nullptr) && (_events->count() > 0)){
+        _events->send(data, event);
+    }
+}
+
+void ESPEasyCfg::pushMessage(const char* msg, const char* type)
+{
+    if((_events != nullptr) && (_events->count() > 0)){
+        JsonDocument doc;
+        doc["type"] = type;
+        doc["message"] = msg;
+        String data;
+        serializeJson(doc, data);
+        _events->send(data.c_str(), "message");
+    }
+}
+
+bool ESPEasyCfg::isAuthorized(AsyncWebServerRequest *request)
+{
+    //Session keys are renewed by applyConfiguration, possibly from the serial task
+    PARAM_LOCK();
+    //Session cookie first, checked without allocation
+    if(_session.validate(request)){
+        return true;
+    }
+    String iotPass = _iotPass.getValue();
+    if(iotPass.length() == 0){
+        return true;
+    }
+    return request->hasHeader("Authorization") && request->authenticate("admin", iotPass.c_str());
+}
+
+void ESPEasyCfg::sendLoginPage(AsyncWebServerRequest *request, bool failed)
+{
+    PARAM_LOCK();
+    String page = F("<!DOCTYPE html><html><head><meta name=\"viewport\" content=\"width=device-width, initial-scale=1\">"
+                    "<title>Login</title></head><body style=\"font-family:sans-serif;margin:2em\"><h3>");
+    page += _iotName.getValue();
+    page += F("</h3>");
+    if(failed){
+        page += F("<p style=\"color:#dc3545\">Wrong password</p>");
+    }
+    page += F("<form method=\"post\" action=\"/login\"><input type=\"password\" name=\"password\" "
+              "placeholder=\"IoT password\" autofocus> <button type=\"submit\">Login</button></form></body></html>");
+    AsyncWebServerResponse *response = request->beginResponse(failed ? 401 : 200, "text/html", page);
+    response->addHeader("Cache-Control", "no-store");
+    request->send(response);
+}
+
+void ESPEasyCfg::finishImport(AsyncWebServerRequest *request)
+{
+    if(_importRequest != request){
+        if((_state != ESPEasyCfgState::AP) && !isAuthorized(request))
+            return request->send(401, "text/plain", "Login required");
+        ImportRejection* rejection = (ImportRejection*)request->_tempObject;
+        if(rejection != nullptr)
+            return _admission.reject(request, rejection->code, rejection->retryAfter);
+        return request->send(400, "text/plain", "Empty document");
+    }
+    ESPEasyCfgImporter* importer = _importer;
+    _importer = nullptr;
+    _importRequest = nullptr;
+    PARAM_LOCK();
+    const char* error = importer->getError();
+    if(error != nullptr){
+        request->send(400, "text/plain", error);
+    }else if(!importer->getVersion().equals(CFG_VERSION)){
+        request->send(400, "text/plain", "Unsupported version");
+    }else{
+        //Same path as /configPost, so values go through their validators
+        String str;
+        int8_t action = 0;
+        bool persistedChanged = false;
+        JsonObject values = importer->getValues();
+        uint32_t generation = applyConfiguration(values, str, action, persistedChanged);
+        AsyncJsonResponse * response = new AsyncJsonResponse(false);
+        JsonObject root = response->getRoot().as<JsonObject>();
+        root["imported"] = importer->getCount();
+        root["ignored"] = importer->getIgnored();
+        if(str.length()>0){
+            root["message"] = str;
+        }
+        if(action != 0){
+            root["action"] = action;
+        }
+        root["generation"] = generation;
+        sendJSON(request, response);
+        commitConfiguration(true, persistedChanged);
+    }
+    delete importer;
+}
+
+uint32_t ESPEasyCfg::applyConfiguration(ArduinoJson::JsonObject& json, String& msg, int8_t& action, bool& persistedChanged)
+{
+    String oldPass = _iotPass.getValue();
+    String oldIP = _staticIP.getValue();
+    String oldMask = _staticMask.getValue();
+    String oldGateway = _staticGateway.getValue();
+    String oldDNS = _staticDNS.getValue();
+    fromJSON(json, &_paramGrp, msg, action, persistedChanged);
+    if(!validateStaticIP(msg)){
+        //Rejected as a whole, parameter validators only see their own value
+        _staticIP.setValue(oldIP);
+        _staticMask.setValue(oldMask);
+        _staticGateway.setValue(oldGateway);
+        _staticDNS.setValue(oldDNS);
+        persistedChanged = false;
+    }else if((_staticIP.getValue() != oldIP) || (_staticMask.getValue() != oldMask) ||
+            (_staticGateway.getValue() != oldGateway) || (_staticDNS.getValue() != oldDNS)){
+        //New IP configuration is applied on reconnection
+        if(_state == ESPEasyCfgState::Connected){
+            if(_staticIP.getValue().length()>0){
+                msg += "Device will be reachable at ";
+                msg += _staticIP.getValue();
+            }else{
+                msg += "Device will use DHCP.";
+            }
+            restartConnection();
+        }
+    }
+    if(_iotPass.getValue() != oldPass){
+        //Password changed, log out everybody
+        _session.renew();
+    }
+    return ++_configGeneration;
+}
+
+void ESPEasyCfg::commitConfiguration(bool saveAll, bool persistedChanged)
+{
+    if(saveAll){
+        saveParameters();
+    }else if(persistedChanged){
+        storeParameters();
+    }
+    pushEvent("config", String(_configGeneration).c_str());
+    pushEvent("state", state_names[static_cast<int>(ESPEasyCfgState::Reconfigured)]);
+    postState(ESPEasyCfgState::Reconfigured);
+    if(_state == ESPEasyCfgState::AP){
+        _lastApUsage = millis();
+    }
+}
+
+ESPEasyCfgAbstractParameter* ESPEasyCfg::findParameter(const char* id)
+{
+    for(ESPEasyCfgParameterGroup* grp = &_paramGrp; grp != nullptr; grp = grp->getNext()){
+        for(ESPEasyCfgAbstractParameter* param = grp->getFirst(); param != nullptr; param = param->getNextParameter()){
+            if(strcmp(param->getIdentifier(), id) == 0){
+                return param;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void ESPEasyCfg::setSerialProvisioning(Stream* stream)
+{
+    _serial = stream;
+    _serialLen = 0;
+#ifdef ESP32
+    _serialEvent = false;
+#endif
+    wakeUp();
+}
+
+#ifdef ESP32
+void ESPEasyCfg::setSerialProvisioning(HardwareSerial* serial)
+{
+    setSerialProvisioning(static_cast<Stream*>(serial));
+    if(serial != nullptr){
+        serial->onReceive([this](){
+            wakeUp();
+        });
+        _serialEvent = true;
+    }
+}
+#endif
+
+void ESPEasyCfg::pollSerial()
+{
+    while(_serial->available() > 0){
+        int c = _serial->read();
+        if(c < 0){
+            break;
+        }
+        if(c == '\r'){
+            continue;
+        }
+        if(c == '\n'){
+            _serialLine[_serialLen] = '\0';
+            if(_serialOverflow){
+                _serial->println(F("ERR Line too long"));
+            }else if(_serialLen > 0){
+                serialCommand(_serialLine);
+            }
+            _serialLen = 0;
+            _serialOverflow = false;
+        }else if(_serialLen < (sizeof(_serialLine) - 1)){
+            _serialLine[_serialLen++] = (char)c;
+        }else{
+            _serialOverflow = true;
+        }
+    }
+}
+
+void ESPEasyCfg::serialCommand(char* line)
+{
+    //Also held by isAuthorized(), COMMIT and APPLY may renew the session keys
+    PARAM_LOCK();
+    //Splits command, identifier and value (rest of line)
+    char* cmd = line;
+    char* id = strchr(cmd, ' ');
+    char* value = nullptr;
+    if(id != nullptr){
+        *id++ = '\0';
+        value = strchr(id, ' ');
+        if(value != nullptr){
+            *value++ = '\0';
+        }
+    }
+    auto printValue = [this](ESPEasyCfgAbstractParameter* param){
+        const char* type = param->getInputType();
+        if((type != nullptr) && (strcmp(type, "password") == 0)){
+            _serial->print(F("----------"));
+        }else{
+            _serial->print(param->toString());
+        }
+    };
+    if(strcasecmp(cmd, "GET") == 0){
+        ESPEasyCfgAbstractParameter* param = (id != nullptr) ? findParameter(id) : nullptr;
+        if(param == nullptr){
+            _serial->println(F("ERR Unknown parameter"));
+            return;
+        }
+        _serial->print(F("OK "));
+        printValue(param);
+        _serial->println();
+    }else if(strcasecmp(cmd, "SET") == 0){
+        if((id == nullptr) || (findParameter(id) == nullptr)){
+            _serial->println(F("ERR Unknown parameter"));
+            return;
+        }
+        //Checked by validators on commit, as for /configPost
+        _serialStaged[String(id)] = String(value != nullptr ? value : "");
+        _serial->println(F("OK"));
+    }else if((strcasecmp(cmd, "COMMIT") == 0) || (strcasecmp(cmd, "APPLY") == 0)){
+        bool saveAll = (strcasecmp(cmd, "COMMIT") == 0);
+        if(_serialStaged.size() == 0){
+            if(!saveAll){
+                _serial->println(F("ERR Nothing to apply"));
+                return;
+            }
+            //Commits values applied before
+            saveParameters();
+            _serial->print(F("OK "));
+            _serial->println(_configGeneration);
+            return;
+        }
+        String msg;
+        int8_t action = 0;
+        bool persistedChanged = false;
+        JsonObject values = _serialStaged.as<JsonObject>();
+        uint32_t generation = applyConfiguration(values, msg, action, persistedChanged);
+        _serialStaged.clear();
+        commitConfiguration(saveAll, persistedChanged);
+        msg.replace('\n', ' ');
+        _serial->print(F("OK "));
+        _serial->print(generation);
+        if(msg.length() > 0){
+            _serial->print(' ');
+            _serial->print(msg);
+        }
+        _serial->println();
+    }else if(strcasecmp(cmd, "ABORT") == 0){
+        _serialStaged.clear();
+        _serial->println(F("OK"));
+    }else if(strcasecmp(cmd, "LIST") == 0){
+        for(ESPEasyCfgParameterGroup* grp = &_paramGrp; grp != nullptr; grp = grp->getNext()){
+            for(ESPEasyCfgAbstractParameter* param = grp->getFirst(); param != nullptr; param = param->getNextParameter()){
+                _serial->print(param->getIdentifier());
+                _serial->print('=');
+                printValue(param);
+                _serial->println();
+            }
+        }
+        _serial->println(F("OK"));
+    }else if(strcasecmp(cmd, "STATE") == 0){
+        _serial->print(F("OK "));
+        _serial->println(state_names[static_cast<int>(_state)]);
+    }else{
+        _serial->println(F("ERR Unknown command"));
+    }
+}
+
+void ESPEasyCfg::saveParameters() {
+    commitParameters();
+    storeParameters();
+}
+
+void ESPEasyCfg::commitParameters() {
+    for(ESPEasyCfgParameterGroup* grp = &_paramGrp; grp != nullptr; grp = grp->getNext()){
+        for(ESPEasyCfgAbstractParameter* param = grp->getFirst(); param != nullptr; param = param->getNextParameter()){
+            param->commit();
+        }
+    }
+}
+
+void ESPEasyCfg::storeParameters() {
+    if(_paramManager)
+        _paramManager->saveParameters(&_paramGrp, CFG_VERSION);
+    pushEvent("saved", String(_configGeneration).c_str());
+}
+
 void ESPEasyCfg::resetToDefaults() {
     //TODO: Reset the captive portal without reseting ESP
     _paramManager->resetToFactory();
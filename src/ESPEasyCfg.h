@@ -6,10 +6,47 @@
 #include <AsyncJson.h>
 #include "ESPEasyCfgParameter.h"
 #include "ESPEasyCfgEnumParameter.h"
-#include <DNSServer.h>
+#include "ESPEasyCfgConnectionCache.h"
+#include "ESPEasyCfgNetwork.h"
+#include "ESPEasyCfgBackoff.h"
+#include "ESPEasyCfgDNSServer.h"
+#include "ESPEasyCfgScanService.h"
+#include "ESPEasyCfgEventQueue.h"
+#include "ESPEasyCfgAdmission.h"
+#include "ESPEasyCfgSession.h"
+#include "ESPEasyCfgInfo.h"
+#include "ESPEasyCfgTransfer.h"
+#include <atomic>
+#ifdef ESP32
+#include <WiFi.h>
+#elif defined(ESP8266)
+#include <ESP8266WiFi.h>
+#endif
+
+//Number of state/message events waiting for dispatch (power of 2)
+#ifndef ESPEASYCFG_EVENT_QUEUE_SIZE
+#define ESPEASYCFG_EVENT_QUEUE_SIZE 16
+#endif
+
+//Maximum length of a queued message, longer ones are truncated
+#ifndef ESPEASYCFG_EVENT_MSG_SIZE
+#define ESPEASYCFG_EVENT_MSG_SIZE 64
+#endif
 
+//Maximum number of state handlers and of message handlers
+#ifndef ESPEASYCFG_MAX_SUBSCRIBERS
+#define ESPEASYCFG_MAX_SUBSCRIBERS 4
+#endif
+
+//Maximum length of a serial provisioning command, longer ones are rejected
+#ifndef ESPEASYCFG_SERIAL_LINE_SIZE
+#define ESPEASYCFG_SERIAL_LINE_SIZE 160
+#endif
 
 void ESPEasyCfgMonitorTask(void* instance);
+#ifdef ESP32
+void ESPEasyCfgEventTask(void* instance);
+#endif
 
 /**
  * Application state
@@ -31,30 +68,152 @@ typedef std::function<void(ESPEasyCfgState)> StateHandlerFunction;
 enum class ESPEasyCfgMessageType {Info, Warning, Error};
 typedef std::function<void(const char*, ESPEasyCfgMessageType)> MessageHandlerFunction;
 
+/**
+ * WiFi power saving mode when connected
+ * @None Radio always on (lowest latency)
+ * @Modem Modem sleep, radio wakes up at each DTIM
+ * @Light Deeper sleep, radio wakes up every listen interval
+ */
+enum class ESPEasyCfgPowerMode {None, Modem, Light};
+
 class ESPEasyCfg
 {
-    private:    
+    private:
+        /**
+         * Phase of the connection
+         * @Direct Connecting to a known BSSID and channel
+         * @Probing Scanning for the configured SSID only
+         * @Full Connecting with a full scan
+         */
+        enum class ConnectPhase {Direct, Probing, Full};
+
+        /**
+         * Access point of a known network found by scan
+         */
+        struct Candidate {
+            uint8_t network;                        //!< Index of the known network
+            uint8_t bssid[6];                       //!< BSSID of the access point
+            int32_t channel;                        //!< Channel of the access point
+            int32_t rssi;                           //!< Signal strength
+        };
+
+        /**
+         * State change or message waiting to be dispatched to handlers
+         */
+        struct Event {
+            bool isMessage;                         //!< True for a message, false for a state change
+            ESPEasyCfgState state;                  //!< New state
+            ESPEasyCfgMessageType msgType;          //!< Type of message
+            char msg[ESPEASYCFG_EVENT_MSG_SIZE];    //!< Message text
+        };
+
         AsyncWebServer *_webServer;                 //!< Reference to the webserver
         ESPEasyCfgParameter<String> _iotName;       //!< Name of this thing (parameter)
         ESPEasyCfgParameter<String> _iotPass;       //!< Password of this thing
         ESPEasyCfgParameter<String> _wifiSSID;      //!< SSID of the WiFi network to connect to
         ESPEasyCfgParameter<String> _wifiPass;      //!< Password of WiFi to connect to (blank : open)
+        ESPEasyCfgParameter<uint16_t> _wifiPriority;//!< Priority of the WiFi network
+        ESPEasyCfgNetwork _networks[ESPEASYCFG_MAX_NETWORKS-1]; //!< Additional WiFi networks
+        ESPEasyCfgParameter<String> _staticIP;      //!< Static IP address (blank : DHCP)
+        ESPEasyCfgParameter<String> _staticMask;    //!< Static subnet mask
+        ESPEasyCfgParameter<String> _staticGateway; //!< Static gateway address
+        ESPEasyCfgParameter<String> _staticDNS;     //!< Static DNS server (blank : gateway)
         ESPEasyCfgParameterGroup _paramGrp;         //!< Group for holding build-in parameters
+        ESPEasyCfgParameterGroup _ipGrp;            //!< Group for holding build-in IP parameters
+        ESPEasyCfgInfo _ipInfo;                     //!< IP address information
+        ESPEasyCfgInfo _maskInfo;                   //!< Subnet mask information
+        ESPEasyCfgInfo _gatewayInfo;                //!< Gateway address information
+        ESPEasyCfgInfo _dnsInfo;                    //!< DNS server information
+        ESPEasyCfgInfo _macInfo;                    //!< MAC address information
+        ESPEasyCfgInfo _channelInfo;                //!< WiFi channel information
+        ESPEasyCfgInfo _rssiInfo;                   //!< WiFi RSSI information
+        ESPEasyCfgInfo _uptimeInfo;                 //!< Uptime information
+        ESPEasyCfgInfo _droppedInfo;                //!< Dropped events information
+        ESPEasyCfgInfo _rejectedInfo;               //!< Rejected requests information
+        ESPEasyCfgInfo* _firstInfo;                 //!< First information shown on the configuration page
+        uint32_t _stateGeneration;                  //!< Incremented on each state change
         ESPEasyCfgState _state;                     //!< State of this application
         AsyncCallbackJsonWebHandler* _cfgHandler;   //!< Web handler to handle set of parameter
         AsyncWebHandler* _fileHandler;              //!< Web handler for static files stored in SPIFFS on /wwww/
-        DNSServer* _dnsServer;                      //!< DNS server to handle captive portal redirections
+        AsyncEventSource* _events;                  //!< Server-Sent Events channel pushing portal events
+        ESPEasyCfgAdmission _admission;             //!< Admission control of JSON endpoints
+        ESPEasyCfgSession _session;                 //!< Sessions of logged in clients
+        bool _authRequired;                         //!< True if pages and events need a session
+        ESPEasyCfgImporter* _importer;              //!< Configuration import in progress
+        AsyncWebServerRequest* _importRequest;      //!< Request of the import in progress
+        Stream* _serial;                            //!< Stream of serial provisioning, nullptr if disabled
+        char _serialLine[ESPEASYCFG_SERIAL_LINE_SIZE]; //!< Command being received
+        size_t _serialLen;                          //!< Length of _serialLine
+        bool _serialOverflow;                       //!< True if the command being received is too long
+        ArduinoJson::JsonDocument _serialStaged;    //!< Values set by serial, waiting for commit
+        uint32_t _configGeneration;                 //!< Incremented when configuration changes
+        uint32_t _scanEventCount;                   //!< Scan count last pushed to clients
+        ESPEasyCfgDNSServer* _dnsServer;            //!< DNS server to handle captive portal redirections
+        String _portalHost;                         //!< Host of the portal in AP mode (IP address)
+        String _portalURL;                          //!< URL captive portal requests are redirected to
+        String _portalBody;                         //!< Body of captive portal redirections
         ESPEasyCfgParameterManager* _paramManager;  //!< Manager to read/write application parameters        
         long long _lastCon;                         //!< Last millis() of WiFi connection
         long long _lastApUsage;                     //!< Last millis() of AP utilization
         uint8_t _ledPin;                            //!< LED pin to signal activity
         bool _ledActiveLow;                         //!< Led active low cabling
         uint8_t _switchPin;                         //!< Switch pin to reset password
-        int8_t _scanCount;                          //!< WiFi scan
         ArRequestHandlerFunction _rootHandler;      //!< Root handler (if installed)
         ArRequestHandlerFunction _notFoundHandler;  //!< 404 error handler
-        StateHandlerFunction _stateHandler;         //!< Custom handler for monitoring state
-        MessageHandlerFunction _msgHandler;         //!< Custom handler for monitoring messages
+        StateHandlerFunction _stateHandlers[ESPEASYCFG_MAX_SUBSCRIBERS];  //!< Custom handlers for monitoring state
+        MessageHandlerFunction _msgHandlers[ESPEASYCFG_MAX_SUBSCRIBERS];  //!< Custom handlers for monitoring messages
+        ESPEasyCfgEventQueue<Event, ESPEASYCFG_EVENT_QUEUE_SIZE> _eventQueue; //!< Events waiting for dispatch to handlers
+        uint32_t _reportedDrops;                    //!< Number of dropped events already reported
+        size_t _jsonGzipThreshold;                  //!< Minimum JSON response size to be compressed (0 to disable)
+        unsigned long _connectStart;                //!< millis() at start of connection
+        unsigned long _connTimeout;                 //!< Connection timeout before switching to AP
+        unsigned long _lastLedChange;               //!< millis() of last LED toggle
+        bool _ledState;                             //!< Actual LED state
+        unsigned long _lastPrint;                   //!< millis() of last connection progress print
+        ESPEasyCfgConnectionCache _conCache;        //!< Cache of last successful connection
+        bool _fastReconnect;                        //!< True to use the connection cache
+        ConnectPhase _connectPhase;                 //!< Actual phase of the connection
+        unsigned long _phaseStart;                  //!< millis() at start of connection phase
+        bool _probed;                               //!< True if a probe scan was done for this connection
+        uint8_t _network;                           //!< Index of the network being connected
+        Candidate _candidates[ESPEASYCFG_MAX_NETWORKS]; //!< Access points to try, best first
+        uint8_t _candidateCount;                    //!< Number of access points in _candidates
+        uint8_t _candidateIndex;                    //!< Next access point to try
+        ESPEasyCfgScanService _scanner;             //!< WiFi scan service
+        uint32_t _probeScanCount;                   //!< Scan count when probe started
+        uint8_t _probeChannel;                      //!< Channel of the running probe, 0 for all channels
+        ESPEasyCfgJitterBackoff _defaultBackoff;    //!< Default reconnection policy
+        ESPEasyCfgBackoffPolicy* _backoff;          //!< Actual reconnection policy
+        unsigned long _retryStart;                  //!< millis() when connection was scheduled
+        unsigned long _retryDelay;                  //!< Delay before next connection attempt
+        int8_t _roamThreshold;                      //!< RSSI below which a stronger access point is searched (0 : disabled)
+        uint8_t _roamHysteresis;                    //!< RSSI gain needed to roam, in dB
+        int16_t _rssiAvg;                           //!< Average RSSI of the connection
+        unsigned long _lastRssiSample;              //!< millis() of last RSSI sample
+        unsigned long _lastRoamScan;                //!< millis() of last roaming scan
+        bool _roamScanning;                         //!< True if a roaming scan is running
+        uint32_t _roamScanCount;                    //!< Scan count when roaming scan started
+        ESPEasyCfgPowerMode _powerMode;             //!< Power saving mode when connected
+        uint8_t _listenInterval;                    //!< Listen interval in beacons (light sleep)
+        ESPEasyCfgPowerMode _appliedPowerMode;      //!< Power saving mode actually set
+        bool _powerModeApplied;                     //!< True if _appliedPowerMode is valid
+        std::atomic<uint16_t> _lowLatency;          //!< Number of low latency windows held
+#ifdef ESP32
+        TaskHandle_t _monitorTask;                  //!< Task running the state machine
+        wifi_event_id_t _wifiEventId;               //!< WiFi event handler registration
+        bool _eventTaskEnabled;                     //!< True to dispatch events from a dedicated task
+        BaseType_t _eventTaskCore;                  //!< Core of the event task
+        UBaseType_t _eventTaskPriority;             //!< Priority of the event task
+        TaskHandle_t _eventTask;                    //!< Task dispatching events to handlers
+        SemaphoreHandle_t _paramMutex;              //!< Serialises parameters and session keys between web handlers and serial provisioning
+        bool _serialEvent;                          //!< True if the serial port wakes up the monitor task on receive
+#else
+        volatile bool _wakeUp;                      //!< Set by events to run the state machine
+        unsigned long _lastRun;                     //!< millis() of last state machine run
+        unsigned long _nextRun;                     //!< Delay before next state machine run
+        WiFiEventHandler _gotIpHandler;             //!< Handler of WiFi got IP event
+        WiFiEventHandler _disconnectedHandler;      //!< Handler of WiFi disconnection event
+#endif
         /**
          * Serialize parameters to JSON
          * @param arr JSON array to put parameters to
@@ -62,6 +221,20 @@ class ESPEasyCfg
          */
         void toJSON(ArduinoJson::JsonArray& arr, ESPEasyCfgParameterGroup* first);
 
+        /**
+         * Serialize parameters of a single group to JSON
+         * @param arr JSON array to put the group to
+         * @param grp Parameter group
+         */
+        void groupToJSON(ArduinoJson::JsonArray& arr, ESPEasyCfgParameterGroup* grp);
+
+        /**
+         * Serialize names of parameter groups and their number of
+         * visible parameters to JSON
+         * @param arr JSON array to put groups to
+         */
+        void indexToJSON(ArduinoJson::JsonArray& arr);
+
         /**
          * Parse parameters from JSON and store it into parameters
          * @param json JSON object to be parsed
@@ -69,22 +242,29 @@ class ESPEasyCfg
          * @param msg Message to be displayed to user
          * @param action Action to be performed
          */
-        void fromJSON(ArduinoJson::JsonObject& json, ESPEasyCfgParameterGroup* first, String& msg, int8_t& action);
+        void fromJSON(ArduinoJson::JsonObject& json, ESPEasyCfgParameterGroup* first, String& msg, int8_t& action,
+                        bool& persistedChanged);
 
         /**
          * Adds informations to JSON data
          */
-        void addInfosPairToJSON(ArduinoJson::JsonArray& arr, const char* name, const String& value);
+        void addInfosToJSON(ArduinoJson::JsonArray& arr);
 
         /**
-         * Adds informations to JSON data
+         * Sends a JSON response
+         * Response is gzipped on the fly if large enough and accepted by the client
+         * @param request Request to answer
+         * @param response JSON response to send (ownership is taken)
+         * @param cacheControl Cache-Control header value (nullptr for none)
+         * @param etag ETag header value (nullptr for none)
          */
-        void addInfosToJSON(ArduinoJson::JsonArray& arr);
+        void sendJSON(AsyncWebServerRequest *request, AsyncJsonResponse* response, const char* cacheControl = nullptr,
+                        const char* etag = nullptr);
 
         /**
-         * Start and run DNS server
+         * Starts DNS server if not running
          */
-        void runDNS();
+        void startDNS();
         /**
          * Stops and destroy the DNS server
          */
@@ -95,21 +275,269 @@ class ESPEasyCfg
          */
         void switchToAP();
 
+        /**
+         * Redirects a request to the captive portal
+         */
+        void sendPortalRedirect(AsyncWebServerRequest *request);
+
         /**
          * Switch to station
          */
         void switchToSTA();
+
+        /**
+         * Starts WiFi connection to a known network
+         * @param network Index of the network (0 is the main network)
+         * @param channel Channel hint (0 to scan all channels)
+         * @param bssid BSSID hint (nullptr for any)
+         */
+        void beginSTA(uint8_t network, int32_t channel, const uint8_t* bssid);
+
+        /**
+         * Gets SSID of a known network
+         * @param network Index of the network (0 is the main network)
+         * @return SSID, empty if network is not configured
+         */
+        String getNetworkSSID(uint8_t network);
+
+        /**
+         * Gets password of a known network
+         * @param network Index of the network (0 is the main network)
+         */
+        String getNetworkPass(uint8_t network);
+
+        /**
+         * Gets priority of a known network
+         * @param network Index of the network (0 is the main network)
+         */
+        uint16_t getNetworkPriority(uint8_t network);
+
+        /**
+         * Gets index of the first configured network
+         * @return Network index or ESPEASYCFG_MAX_NETWORKS if none is configured
+         */
+        uint8_t getFirstNetwork();
+
+        /**
+         * Sets the connection phase
+         */
+        void setConnectPhase(ConnectPhase phase);
+
+        /**
+         * Starts a scan looking for the known networks
+         * A recent scan result is used if available
+         * @param channel Channel of the last connection to look at first, 0 for all channels
+         */
+        void startProbe(uint8_t channel = 0);
+
+        /**
+         * Checks if a known network may be hidden
+         * True if a full scan was done and a known SSID was not in its results
+         */
+        bool hasHiddenNetwork();
+
+        /**
+         * Ranks known networks found by the probe scan and connects
+         * to the best one
+         */
+        void connectFromProbe();
+
+        /**
+         * Connects to the next access point found by scan
+         * Falls back to a full connection if there is no more candidate
+         */
+        void connectNextCandidate();
+
+        /**
+         * Samples signal strength and roams to a stronger access point
+         * of the same network if needed
+         * @param now Actual millis()
+         * @return Time in ms before this must be called again
+         */
+        unsigned long processRoaming(unsigned long now);
+
+        /**
+         * Applies IP configuration before connecting
+         * Static configuration is used if set, else DHCP
+         */
+        void configureIP();
+
+        /**
+         * Validates an IP address parameter
+         * @param param Parameter being validated
+         * @param newValue New value of the parameter
+         * @param msg Message to be displayed to user
+         * @param isMask True if the address is a subnet mask
+         * @return True if the value is invalid
+         */
+        bool validateAddress(ESPEasyCfgParameter<String> *param, const String& newValue, String& msg, bool isMask);
+
+        /**
+         * Checks that a static IP address comes with a mask and a gateway
+         * Done once all values are applied, as it involves several parameters
+         * @param msg Receives the error message
+         * @return False if the IP configuration is incomplete
+         */
+        bool validateStaticIP(String& msg);
         
         /**
          * Change the state
          */
         void setState(ESPEasyCfgState newState);
+
+        /**
+         * Sets the WiFi power saving mode according to the state
+         * Power saving is only used when connected, outside low latency windows
+         */
+        void applyPowerMode();
+
+        /**
+         * Schedules a connection attempt
+         * @param delay Delay before connecting in ms
+         */
+        void scheduleConnect(unsigned long delay);
+
+        /**
+         * Reconnects after a change of WiFi network settings
+         * @param ssid SSID of the changed network (blank : removed)
+         * @param msg Message to be displayed to user
+         * @param action Receives CLOSE if the portal AP goes down
+         */
+        void reconnectTo(const String& ssid, String& msg, int8_t& action);
+
+        /**
+         * Reconnects immediately, resetting the backoff policy
+         * Used when the WiFi configuration changes
+         */
+        void restartConnection();
         
+        /**
+         * Pushes an event to Server-Sent Events clients
+         * @param event Name of the event
+         * @param data Data of the event
+         */
+        void pushEvent(const char* event, const char* data);
+
+        /**
+         * Pushes a message to Server-Sent Events clients
+         * @param msg Message text
+         * @param type Type of message (info, warning or error)
+         */
+        void pushMessage(const char* msg, const char* type);
+
+        /**
+         * Sets authentication of protected handlers
+         * @param enable True to require the IoT password (if any)
+         */
+        inline void setHandlersAuthentication(bool enable) { _authRequired = enable; }
+
+        /**
+         * Checks if a request is authorized
+         * A valid session cookie is checked first. Basic authentication is
+         * still accepted, for scripts.
+         * @return True if the request has a session, valid credentials
+         *         or if no IoT password is set
+         */
+        bool isAuthorized(AsyncWebServerRequest *request);
+
+        /**
+         * Sends the login page
+         * @param failed True if the last password was wrong
+         */
+        void sendLoginPage(AsyncWebServerRequest *request, bool failed);
+
+        /**
+         * Applies a received configuration document and answers the import request
+         * Values are applied only if the whole document was parsed, and saved
+         * with a single write.
+         */
+        void finishImport(AsyncWebServerRequest *request);
+
+        /**
+         * Applies new parameter values, with their validators
+         * Shared by /configPost, /config/import and serial provisioning
+         * The static IP configuration is checked as a whole, and applied
+         * with a single reconnection
+         * @param json Values by parameter identifier
+         * @param msg Validation messages
+         * @param action Action requested by validators
+         * @param persistedChanged Set to true if a Persisted parameter changed, cleared if the IP configuration is rejected
+         * @return New configuration generation
+         */
+        uint32_t applyConfiguration(ArduinoJson::JsonObject& json, String& msg, int8_t& action, bool& persistedChanged);
+
+        /**
+         * Stores the applied configuration and notifies it
+         * @param saveAll True to commit and store all parameters, false to
+         * store only if a Persisted parameter changed (apply)
+         * @param persistedChanged True if a Persisted parameter changed
+         */
+        void commitConfiguration(bool saveAll, bool persistedChanged);
+
+        /**
+         * Writes parameters with the parameter manager, without committing
+         * OnCommit parameters
+         */
+        void storeParameters();
+
+        /**
+         * Takes actual values of OnCommit parameters as the ones to be stored
+         */
+        void commitParameters();
+
+        /**
+         * Gets a parameter by identifier
+         * @return Parameter, or nullptr if unknown
+         */
+        ESPEasyCfgAbstractParameter* findParameter(const char* id);
+
+        /**
+         * Reads the serial provisioning stream, executing complete commands
+         */
+        void pollSerial();
+
+        /**
+         * Executes a serial provisioning command and writes its answer
+         * @param line Command, modified while parsed
+         */
+        void serialCommand(char* line);
+
+        /**
+         * Runs the state machine once
+         * @return Time in ms before the state machine must run again
+         */
+        unsigned long processState();
+
+        /**
+         * Wakes up the state machine (thread safe)
+         */
+        void wakeUp();
+
         /**
          * Sets LED state
          */
         void setLed(bool state);
 
+        /**
+         * Queues a state change for the handlers
+         */
+        void postState(ESPEasyCfgState state);
+
+        /**
+         * Queues a message for the handlers
+         */
+        void postMessage(const char* msg, ESPEasyCfgMessageType type);
+
+        /**
+         * Wakes up the event task (thread safe)
+         */
+        void notifyEvents();
+
+        /**
+         * Calls message handlers
+         */
+        void callMessageHandlers(const char* msg, ESPEasyCfgMessageType type);
+
         /**
          * Send information message to handler
         */
@@ -125,23 +553,31 @@ class ESPEasyCfg
         */
         void errorMessage(const char* msg);
 
-        /**
-         * Scan available WiFi networks
-        */
-        void scanNetworks();
-
     public:
 #ifdef ESP32
         /**
          * Monitor state
          */
         void monitorState();
+
+        /**
+         * Dispatches events to handlers as they come (event task)
+         */
+        void dispatchTask();
 #elif defined(ESP8266)
 		/**
-		 * Performs background tasks
+		 * Performs background tasks and dispatches pending events
+		 * Returns immediately if no event or deadline is pending
 		 */
 		void loop();
 #endif
+        /**
+         * Calls state and message handlers for pending events
+         * Must be called from the application loop when events are not
+         * dispatched by a task (see setEventTask()). On ESP8266, loop()
+         * calls it.
+         */
+        void dispatchEvents();
         /**
          * Constructor
          * @param webServer Webserver instance
@@ -211,15 +647,34 @@ class ESPEasyCfg
          */
         inline void addParameterGroup(ESPEasyCfgParameterGroup* grp) { _paramGrp.add(grp); }
 
+        /**
+         * Adds an information to the device informations of the
+         * configuration page, after the built-in ones
+         * This method must be called before begin!
+         * @param info Information to be added (not owned)
+         */
+        void addInfo(ESPEasyCfgInfo* info);
+
         /**
          * Sets a state handler callback to be called when portal state
          * changes
+         * Handlers are called asynchronously, from the event task or from
+         * dispatchEvents(), so they can be slow without stalling the portal.
          * @handler Handler function to be called
          */
-        inline void setStateHandler(StateHandlerFunction handler) { _stateHandler = handler; }
+        inline void setStateHandler(StateHandlerFunction handler) { _stateHandlers[0] = handler; }
+
+        /**
+         * Adds a state handler, in addition to the one set by setStateHandler()
+         * This method must be called before begin!
+         * @param handler Handler function to be called
+         * @return False if ESPEASYCFG_MAX_SUBSCRIBERS handlers are already set
+         */
+        bool addStateHandler(StateHandlerFunction handler);
 
         /**
          * Save actual parameters values to flash
+         * OnCommit parameters are committed, Volatile ones are not saved
          */
         void saveParameters();
 
@@ -227,7 +682,136 @@ class ESPEasyCfg
          * Sets the handler to be called to get portal messages
          * @param handler Handler function to be called
         */
-        inline void setMessageHandler(MessageHandlerFunction handler) { _msgHandler = handler; }
+        inline void setMessageHandler(MessageHandlerFunction handler) { _msgHandlers[0] = handler; }
+
+        /**
+         * Adds a message handler, in addition to the one set by setMessageHandler()
+         * This method must be called before begin!
+         * @param handler Handler function to be called
+         * @return False if ESPEASYCFG_MAX_SUBSCRIBERS handlers are already set
+         */
+        bool addMessageHandler(MessageHandlerFunction handler);
+
+#ifdef ESP32
+        /**
+         * Sets how state and message events are dispatched to handlers
+         * By default, a dedicated task calls the handlers. When disabled,
+         * dispatchEvents() must be called from the application loop.
+         * This method must be called before begin!
+         * @param enable True to use a dedicated task
+         * @param core Core the task runs on (tskNO_AFFINITY for any)
+         * @param priority Priority of the task
+         */
+        void setEventTask(bool enable, BaseType_t core = tskNO_AFFINITY, UBaseType_t priority = 1);
+#endif
+
+        /**
+         * Gets the number of state and message events dropped because
+         * handlers did not keep up
+         */
+        inline uint32_t getDroppedEvents() const { return _eventQueue.getDropped(); }
+
+        /**
+         * Sets the minimum size of JSON responses (/config, /scan) to be
+         * compressed when the client supports gzip
+         * @param threshold Size in bytes, 0 to disable compression
+         */
+        inline void setJSONCompressionThreshold(size_t threshold) { _jsonGzipThreshold = threshold; }
+
+        /**
+         * Enables fast reconnection
+         * When enabled, BSSID and channel of the last successful connection
+         * are kept in RTC memory and reused on next connection, skipping the
+         * channel scan. The address is still obtained by DHCP, a cached
+         * lease could have expired. If it fails, a normal connection is done.
+         * @param enable True to enable (default)
+         */
+        inline void setFastReconnect(bool enable) { _fastReconnect = enable; }
+
+        /**
+         * Sets the policy giving delays between connection attempts and
+         * their timeouts. The policy is not owned by this object.
+         * @param policy Policy to use, nullptr to use the default one
+         */
+        void setBackoffPolicy(ESPEasyCfgBackoffPolicy* policy);
+
+        /**
+         * Enables roaming to a stronger access point of the same network
+         * When the average signal strength drops below the threshold, the
+         * network is scanned from time to time and the device reconnects
+         * to another access point if it is stronger by the hysteresis.
+         * Disabled by default. -75 is a good start for multi access point
+         * networks.
+         * @param threshold RSSI threshold in dBm (0 to disable)
+         * @param hysteresis Minimum gain to roam in dB
+         */
+        inline void setRoaming(int8_t threshold, uint8_t hysteresis = 8) {
+            _roamThreshold = threshold;
+            _roamHysteresis = hysteresis;
+        }
+
+        /**
+         * Sets the WiFi power saving mode used when connected
+         * Radio is always on in other states, for responsiveness.
+         * @param mode Power saving mode
+         * @param listenInterval Number of beacons between wake ups in light
+         *        sleep (ESP8266 only, ESP32 uses the DTIM period)
+         */
+        void setPowerMode(ESPEasyCfgPowerMode mode, uint8_t listenInterval = 3);
+
+        /**
+         * Starts a low latency window
+         * Power saving is disabled until endLowLatency() is called. Windows
+         * can be nested.
+         */
+        void beginLowLatency();
+
+        /**
+         * Ends a low latency window started by beginLowLatency()
+         */
+        void endLowLatency();
+
+        /**
+         * Sets the lifetime of login sessions
+         * @param timeout Lifetime in s
+         */
+        inline void setSessionTimeout(uint32_t timeout) { _session.setTimeout(timeout); }
+
+        /**
+         * Enables provisioning through a serial port, without entering AP mode
+         * Line based commands, answered by a line starting with OK or ERR :
+         * - GET <id> : value of a parameter (passwords are masked)
+         * - SET <id> <value> : stages a value, rest of line is the value
+         * - COMMIT : applies and saves staged values, as /configPost does
+         * - APPLY : applies staged values, saving only Persisted parameters
+         * - ABORT : drops staged values
+         * - LIST : one <id>=<value> line per parameter
+         * - STATE : state of the portal
+         * Without receive event, the stream is polled every second when idle
+         * @param stream Stream to read commands from (Serial), nullptr to disable
+         */
+        void setSerialProvisioning(Stream* stream);
+
+#ifdef ESP32
+        /**
+         * Enables provisioning through a serial port, commands being read on
+         * the UART receive event instead of polling
+         * Replaces the onReceive callback of the port.
+         * @param serial Port to read commands from
+         */
+        void setSerialProvisioning(HardwareSerial* serial);
+#endif
+
+        /**
+         * Gets the admission control of the JSON endpoints, to tune
+         * concurrency limits, heap watermark and rate limit (AP mode only)
+         */
+        inline ESPEasyCfgAdmission& getAdmission() { return _admission; }
+
+        /**
+         * Gets the default reconnection policy, to tune its parameters
+         */
+        inline ESPEasyCfgJitterBackoff& getDefaultBackoffPolicy() { return _defaultBackoff; }
 
         /**
          * Resets parameters to default
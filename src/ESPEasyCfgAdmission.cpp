@@ -0,0 +1,115 @@
+#include "ESPEasyCfgAdmission.h"
+#include "ESPEasyCfgConfiguration.h"
+
+#ifdef ESP32
+#define DEFAULT_MIN_FREE_HEAP 16384
+#define DEFAULT_MIN_FREE_BLOCK 8192
+#else
+#define DEFAULT_MIN_FREE_HEAP 8192
+#define DEFAULT_MIN_FREE_BLOCK 4096
+#endif
+#define DEFAULT_RATE 60
+#define DEFAULT_BURST 10
+#define BUSY_RETRY_AFTER 1
+#define LOW_MEMORY_RETRY_AFTER 2
+
+ESPEasyCfgAdmission::ESPEasyCfgAdmission() :
+    _minFreeHeap(DEFAULT_MIN_FREE_HEAP), _minFreeBlock(DEFAULT_MIN_FREE_BLOCK),
+    _rate(DEFAULT_RATE), _burst(DEFAULT_BURST), _rejected(0)
+{
+    _limits[static_cast<int>(ESPEasyCfgEndpoint::Config)] = 2;
+    _limits[static_cast<int>(ESPEasyCfgEndpoint::ConfigPost)] = 1;
+    _limits[static_cast<int>(ESPEasyCfgEndpoint::Scan)] = 2;
+    _limits[static_cast<int>(ESPEasyCfgEndpoint::Login)] = 1;
+    _limits[static_cast<int>(ESPEasyCfgEndpoint::Import)] = 1;
+    memset(_inFlight, 0, sizeof(_inFlight));
+    memset(_clients, 0, sizeof(_clients));
+}
+
+bool ESPEasyCfgAdmission::admit(AsyncWebServerRequest *request, ESPEasyCfgEndpoint endpoint, bool rateLimit)
+{
+    uint32_t retryAfter;
+    int code = acquire(request, endpoint, rateLimit, retryAfter);
+    if(code != 0){
+        reject(request, code, retryAfter);
+        return false;
+    }
+    //Slot is held until the request is freed (connection closed)
+    request->onDisconnect([this, endpoint](){
+        release(endpoint);
+    });
+    return true;
+}
+
+int ESPEasyCfgAdmission::acquire(AsyncWebServerRequest *request, ESPEasyCfgEndpoint endpoint, bool rateLimit,
+                                    uint32_t& retryAfter)
+{
+    int ep = static_cast<int>(endpoint);
+    //Cheapest checks first
+    if((_limits[ep] != 0) && (_inFlight[ep] >= _limits[ep])){
+        DebugPrintln("Endpoint busy, request rejected");
+        retryAfter = BUSY_RETRY_AFTER;
+        return 503;
+    }
+    if(rateLimit && (_rate != 0) && !takeToken(request->client()->remoteIP(), retryAfter)){
+        DebugPrintln("Rate limit reached, request rejected");
+        return 429;
+    }
+#ifdef ESP32
+    uint32_t freeBlock = ESP.getMaxAllocHeap();
+#else
+    uint32_t freeBlock = ESP.getMaxFreeBlockSize();
+#endif
+    if((ESP.getFreeHeap() < _minFreeHeap) || (freeBlock < _minFreeBlock)){
+        DebugPrintln("Low memory, request rejected");
+        retryAfter = LOW_MEMORY_RETRY_AFTER;
+        return 503;
+    }
+    ++_inFlight[ep];
+    return 0;
+}
+
+bool ESPEasyCfgAdmission::takeToken(uint32_t ip, uint32_t& retryAfter)
+{
+    unsigned long now = millis();
+    uint32_t capacity = (uint32_t)_burst * 1000;
+    //Find the client, or reuse the least recently refilled entry
+    Client* client = &_clients[0];
+    for(uint8_t i=0;i<ESPEASYCFG_ADMISSION_CLIENTS;++i){
+        if(_clients[i].ip == ip){
+            client = &_clients[i];
+            break;
+        }
+        if((_clients[i].ip == 0) ||
+            ((client->ip != 0) && ((now - _clients[i].lastRefill) > (now - client->lastRefill)))){
+            client = &_clients[i];
+        }
+    }
+    if(client->ip != ip){
+        //New client, full bucket
+        client->ip = ip;
+        client->tokens = capacity;
+    }else{
+        //Refill at _rate tokens per minute, i.e. _rate/60 1/1000 tokens per ms
+        uint64_t refill = (uint64_t)(now - client->lastRefill) * _rate / 60;
+        client->tokens = ((client->tokens < capacity) && ((capacity - client->tokens) > refill)) ? (client->tokens + (uint32_t)refill) : capacity;
+    }
+    client->lastRefill = now;
+    if(client->tokens < 1000){
+        //Time before the bucket holds a full token, rounded up
+        retryAfter = ((1000 - client->tokens) * 60 + (_rate * 1000) - 1) / (_rate * 1000);
+        return false;
+    }
+    client->tokens -= 1000;
+    return true;
+}
+
+void ESPEasyCfgAdmission::reject(AsyncWebServerRequest *request, int code, uint32_t retryAfter)
+{
+    ++_rejected;
+    AsyncWebServerResponse *response = request->beginResponse(code, "text/plain",
+                                            (code == 429) ? "Too many requests" : "Busy, retry later");
+    response->addHeader("Retry-After", String(retryAfter));
+    response->addHeader("Cache-Control", "no-store");
+    request->send(response);
+}
@@ -0,0 +1,135 @@
+#ifndef _ESPEASYCFG_ADMISSION_H_
+#define _ESPEASYCFG_ADMISSION_H_
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+
+//Number of clients tracked by the rate limiter
+#ifndef ESPEASYCFG_ADMISSION_CLIENTS
+#define ESPEASYCFG_ADMISSION_CLIENTS 8
+#endif
+
+/**
+ * Portal endpoints under admission control
+ * @Config Configuration read (/config)
+ * @ConfigPost Configuration write (/configPost)
+ * @Scan Network scan results (/scan)
+ * @Login Password check (/login)
+ * @Import Configuration import (/config/import)
+ */
+enum class ESPEasyCfgEndpoint {Config, ConfigPost, Scan, Login, Import};
+
+/**
+ * Admission control of the portal JSON endpoints
+ * Each of these requests allocates a full JSON document. To degrade
+ * gracefully instead of running out of memory, requests are rejected
+ * when :
+ * - too many requests of the same endpoint are in flight (503)
+ * - free heap or largest free block is below the watermark (503)
+ * - the client exceeds its request rate, when rate limiting is on (429)
+ * Rejections carry a Retry-After header.
+ * Must be used from the web server context only (not thread safe).
+ */
+class ESPEasyCfgAdmission
+{
+private:
+    /**
+     * Token bucket of a client
+     */
+    struct Client {
+        uint32_t ip;                            //!< IPv4 address of the client (0 : free)
+        uint32_t tokens;                        //!< Available tokens, in 1/1000 token
+        unsigned long lastRefill;               //!< millis() of last refill
+    };
+
+    uint8_t _limits[5];                         //!< Maximum concurrent requests per endpoint (0 : unlimited)
+    uint8_t _inFlight[5];                       //!< Actual concurrent requests per endpoint
+    uint32_t _minFreeHeap;                      //!< Free heap watermark in bytes
+    uint32_t _minFreeBlock;                     //!< Largest free block watermark in bytes
+    uint16_t _rate;                             //!< Request rate per client, in requests per minute
+    uint8_t _burst;                             //!< Maximum burst of requests per client
+    Client _clients[ESPEASYCFG_ADMISSION_CLIENTS]; //!< Token buckets
+    uint32_t _rejected;                         //!< Number of rejected requests
+
+    /**
+     * Takes a token from the bucket of a client
+     * @param ip IPv4 address of the client
+     * @param retryAfter Set to the time in s before a token is available
+     * @return False if the bucket is empty
+     */
+    bool takeToken(uint32_t ip, uint32_t& retryAfter);
+
+public:
+    ESPEasyCfgAdmission();
+
+    /**
+     * Takes a slot of an endpoint, without answering the request
+     * For requests which must be checked before their body is received.
+     * The slot is released with release().
+     * @param request Request to admit
+     * @param endpoint Endpoint of the request
+     * @param rateLimit True to apply the per client rate limit
+     * @param retryAfter Set to the time in s before retrying, if rejected
+     * @return 0 if admitted, else HTTP status of the rejection
+     */
+    int acquire(AsyncWebServerRequest *request, ESPEasyCfgEndpoint endpoint, bool rateLimit, uint32_t& retryAfter);
+
+    /**
+     * Releases a slot taken by acquire()
+     */
+    inline void release(ESPEasyCfgEndpoint endpoint) { --_inFlight[static_cast<int>(endpoint)]; }
+
+    /**
+     * Answers a rejected request
+     * @param code HTTP status, as given by acquire()
+     * @param retryAfter Time in s before retrying
+     */
+    void reject(AsyncWebServerRequest *request, int code, uint32_t retryAfter);
+
+    /**
+     * Admits a request or answers it with an error
+     * When admitted, the request holds a slot of the endpoint until it
+     * is done
+     * @param request Request to admit
+     * @param endpoint Endpoint of the request
+     * @param rateLimit True to apply the per client rate limit
+     * @return False if the request was rejected (response is sent)
+     */
+    bool admit(AsyncWebServerRequest *request, ESPEasyCfgEndpoint endpoint, bool rateLimit);
+
+    /**
+     * Sets the maximum number of concurrent requests of an endpoint
+     * @param endpoint Endpoint to limit
+     * @param limit Maximum number of requests in flight, 0 for unlimited
+     */
+    inline void setConcurrencyLimit(ESPEasyCfgEndpoint endpoint, uint8_t limit) {
+        _limits[static_cast<int>(endpoint)] = limit;
+    }
+
+    /**
+     * Sets the heap watermark below which requests are rejected
+     * @param minFreeHeap Minimum free heap in bytes (0 to disable)
+     * @param minFreeBlock Minimum largest free block in bytes (0 to disable)
+     */
+    inline void setHeapWatermark(uint32_t minFreeHeap, uint32_t minFreeBlock) {
+        _minFreeHeap = minFreeHeap;
+        _minFreeBlock = minFreeBlock;
+    }
+
+    /**
+     * Sets the rate limit applied to each client
+     * @param rate Sustained rate in requests per minute (0 to disable)
+     * @param burst Number of requests allowed at once
+     */
+    inline void setRateLimit(uint16_t rate, uint8_t burst) {
+        _rate = rate;
+        _burst = burst;
+    }
+
+    /**
+     * Gets the number of rejected requests
+     */
+    inline uint32_t getRejected() const { return _rejected; }
+};
+
+#endif
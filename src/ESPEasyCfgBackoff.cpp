@@ -0,0 +1,46 @@
+#include "ESPEasyCfgBackoff.h"
+
+ESPEasyCfgJitterBackoff::ESPEasyCfgJitterBackoff(unsigned long firstRetry, unsigned long base,
+                                                 unsigned long cap, unsigned long firstTimeout,
+                                                 unsigned long retryTimeout) :
+    _firstRetry(firstRetry), _base(base), _cap(cap), _firstTimeout(firstTimeout),
+    _retryTimeout(retryTimeout), _sleep(base), _attempt(0)
+{
+}
+
+void ESPEasyCfgJitterBackoff::reset()
+{
+    _sleep = _base;
+    _attempt = 0;
+}
+
+unsigned long ESPEasyCfgJitterBackoff::nextDelay()
+{
+    unsigned long upper = (_sleep > (_cap / 3)) ? _cap : (_sleep * 3);
+    if(upper < _base){
+        upper = _base;
+    }
+    _sleep = random(_base, upper + 1);
+    if(_sleep > _cap){
+        _sleep = _cap;
+    }
+    if(_attempt < 0xFFFF){
+        ++_attempt;
+    }
+    return _sleep;
+}
+
+unsigned long ESPEasyCfgJitterBackoff::lostDelay()
+{
+    if(_attempt != 0){
+        return nextDelay();
+    }
+    //Fast path, link is likely to come back soon
+    ++_attempt;
+    return random(_firstRetry + 1);
+}
+
+unsigned long ESPEasyCfgJitterBackoff::getConnectTimeout()
+{
+    return (_attempt == 0) ? _firstTimeout : _retryTimeout;
+}
@@ -0,0 +1,84 @@
+#ifndef _ESPEASYCFG_BACKOFF_H_
+#define _ESPEASYCFG_BACKOFF_H_
+
+#include <Arduino.h>
+
+/**
+ * Policy giving the timing of WiFi connection attempts
+ * After a failed attempt (or a lost connection), nextDelay() is called to
+ * know how long to wait before the next attempt. Each attempt is bounded by
+ * getConnectTimeout(). The policy is reset when a connection succeeds or
+ * when the configuration changes.
+ */
+class ESPEasyCfgBackoffPolicy
+{
+public:
+    virtual inline ~ESPEasyCfgBackoffPolicy() {};
+
+    /**
+     * Resets the policy (connection is established)
+     */
+    virtual void reset() = 0;
+
+    /**
+     * Gets the delay before the next connection attempt
+     * @return Delay in ms
+     */
+    virtual unsigned long nextDelay() = 0;
+
+    /**
+     * Gets the delay before reconnecting after an established connection is lost
+     * @return Delay in ms, nextDelay() by default
+     */
+    virtual unsigned long lostDelay() { return nextDelay(); }
+
+    /**
+     * Gets the timeout of the next connection attempt
+     * @return Timeout in ms
+     */
+    virtual unsigned long getConnectTimeout() = 0;
+};
+
+/**
+ * Exponential backoff with decorrelated jitter
+ * A lost connection is first retried after a short random delay (fast
+ * path). Other retries, including the one after the initial attempt,
+ * wait a random delay between base and three times the previous delay,
+ * capped, so that the portal opens. Randomness prevents devices losing their connection at
+ * the same time from reconnecting in lockstep.
+ */
+class ESPEasyCfgJitterBackoff : public ESPEasyCfgBackoffPolicy
+{
+private:
+    unsigned long _firstRetry;                  //!< Maximum delay of the first retry
+    unsigned long _base;                        //!< Minimum delay of next retries
+    unsigned long _cap;                         //!< Maximum delay
+    unsigned long _firstTimeout;                //!< Timeout of the first attempt
+    unsigned long _retryTimeout;                //!< Timeout of next attempts
+    unsigned long _sleep;                       //!< Last delay
+    uint16_t _attempt;                          //!< Number of retries since reset
+public:
+    /**
+     * Constructor
+     * @param firstRetry Maximum delay of the first retry after a lost connection in ms
+     * @param base Minimum delay of next retries in ms
+     * @param cap Maximum delay in ms
+     * @param firstTimeout Timeout of the first connection attempt in ms
+     * @param retryTimeout Timeout of next connection attempts in ms
+     */
+    ESPEasyCfgJitterBackoff(unsigned long firstRetry = 1000, unsigned long base = 30000,
+                            unsigned long cap = 600000, unsigned long firstTimeout = 60000,
+                            unsigned long retryTimeout = 10000);
+    void reset() override;
+    unsigned long nextDelay() override;
+    unsigned long lostDelay() override;
+    unsigned long getConnectTimeout() override;
+
+    inline void setFirstRetry(unsigned long firstRetry) { _firstRetry = firstRetry; }
+    inline void setBase(unsigned long base) { _base = base; }
+    inline void setCap(unsigned long cap) { _cap = cap; }
+    inline void setFirstTimeout(unsigned long timeout) { _firstTimeout = timeout; }
+    inline void setRetryTimeout(unsigned long timeout) { _retryTimeout = timeout; }
+};
+
+#endif
@@ -0,0 +1,71 @@
+#include "ESPEasyCfgConnectionCache.h"
+
+#ifdef ESP32
+#include <WiFi.h>
+#include <esp_attr.h>
+//Survives software resets and deep sleep
+RTC_NOINIT_ATTR static ESPEasyCfgConnectionData rtcConnectionData;
+#elif defined(ESP8266)
+#include <ESP8266WiFi.h>
+#endif
+
+ESPEasyCfgConnectionCache::ESPEasyCfgConnectionCache()
+{
+    memset(&_data, 0, sizeof(_data));
+}
+
+uint32_t ESPEasyCfgConnectionCache::checksum(const String& ssid, const String& pass) const
+{
+    //FNV-1a of the data (without checksum) followed by credentials
+    uint32_t hash = 2166136261UL;
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(&_data) + sizeof(_data.checksum);
+    for(size_t i=0;i<(sizeof(_data) - sizeof(_data.checksum));++i){
+        hash = (hash ^ p[i]) * 16777619UL;
+    }
+    for(size_t i=0;i<ssid.length();++i){
+        hash = (hash ^ (uint8_t)ssid[i]) * 16777619UL;
+    }
+    hash = (hash ^ 0) * 16777619UL;
+    for(size_t i=0;i<pass.length();++i){
+        hash = (hash ^ (uint8_t)pass[i]) * 16777619UL;
+    }
+    return hash;
+}
+
+bool ESPEasyCfgConnectionCache::load(const String& ssid, const String& pass)
+{
+#ifdef ESP32
+    memcpy(&_data, &rtcConnectionData, sizeof(_data));
+#else
+    if(!ESP.rtcUserMemoryRead(ESPEASYCFG_RTC_OFFSET, reinterpret_cast<uint32_t*>(&_data), sizeof(_data))){
+        return false;
+    }
+#endif
+    return (_data.channel != 0) && (_data.checksum == checksum(ssid, pass));
+}
+
+void ESPEasyCfgConnectionCache::save(const String& ssid, const String& pass)
+{
+    memset(&_data, 0, sizeof(_data));
+    const uint8_t* bssid = WiFi.BSSID();
+    if(bssid){
+        memcpy(_data.bssid, bssid, sizeof(_data.bssid));
+    }
+    _data.channel = WiFi.channel();
+    _data.checksum = checksum(ssid, pass);
+#ifdef ESP32
+    memcpy(&rtcConnectionData, &_data, sizeof(_data));
+#else
+    ESP.rtcUserMemoryWrite(ESPEASYCFG_RTC_OFFSET, reinterpret_cast<uint32_t*>(&_data), sizeof(_data));
+#endif
+}
+
+void ESPEasyCfgConnectionCache::invalidate()
+{
+    memset(&_data, 0, sizeof(_data));
+#ifdef ESP32
+    memcpy(&rtcConnectionData, &_data, sizeof(_data));
+#else
+    ESP.rtcUserMemoryWrite(ESPEASYCFG_RTC_OFFSET, reinterpret_cast<uint32_t*>(&_data), sizeof(_data));
+#endif
+}
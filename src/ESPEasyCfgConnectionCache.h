@@ -0,0 +1,66 @@
+#ifndef _ESPEASYCFG_CONNECTIONCACHE_H_
+#define _ESPEASYCFG_CONNECTIONCACHE_H_
+
+#include <Arduino.h>
+
+//Offset (in 4 bytes blocks) of the cache in ESP8266 RTC user memory
+#ifndef ESPEASYCFG_RTC_OFFSET
+#define ESPEASYCFG_RTC_OFFSET 32
+#endif
+
+/**
+ * Connection informations kept in RTC memory
+ */
+struct ESPEasyCfgConnectionData {
+    uint32_t checksum;          //!< Checksum of data and credentials
+    uint8_t bssid[6];           //!< BSSID of the access point
+    uint8_t channel;            //!< WiFi channel
+    uint8_t reserved;           //!< Padding
+};
+
+/**
+ * Cache of the last successful WiFi connection
+ * The cache is stored in RTC memory, surviving resets and deep sleep
+ * but not power loss. It is only valid for the credentials it was saved with.
+ * The IP configuration is not cached: without a clock surviving resets, the
+ * age of the DHCP lease is unknown and reusing it could conflict with
+ * another host.
+ */
+class ESPEasyCfgConnectionCache
+{
+private:
+    ESPEasyCfgConnectionData _data;        //!< Copy of cached data
+
+    /**
+     * Computes checksum of data and credentials
+     */
+    uint32_t checksum(const String& ssid, const String& pass) const;
+
+public:
+    ESPEasyCfgConnectionCache();
+
+    /**
+     * Loads cached connection from RTC memory
+     * @param ssid SSID of the network to connect to
+     * @param pass Password of the network
+     * @return True if cache is valid for these credentials
+     */
+    bool load(const String& ssid, const String& pass);
+
+    /**
+     * Saves the actual WiFi connection to RTC memory
+     * @param ssid SSID of the connected network
+     * @param pass Password of the network
+     */
+    void save(const String& ssid, const String& pass);
+
+    /**
+     * Invalidates the cache
+     */
+    void invalidate();
+
+    inline const uint8_t* getBSSID() const { return _data.bssid; }
+    inline uint8_t getChannel() const { return _data.channel; }
+};
+
+#endif
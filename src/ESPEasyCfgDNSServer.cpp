@@ -0,0 +1,126 @@
+#include "ESPEasyCfgDNSServer.h"
+
+#define DNS_PORT 53
+#define DNS_HEADER_SIZE 12
+#define DNS_TYPE_A 1
+#define DNS_TYPE_ANY 255
+#define DNS_CLASS_IN 1
+
+ESPEasyCfgDNSServer::ESPEasyCfgDNSServer()
+#ifndef ESP32
+    : _pcb(nullptr)
+#endif
+{
+    memset(_answer, 0, sizeof(_answer));
+}
+
+ESPEasyCfgDNSServer::~ESPEasyCfgDNSServer()
+{
+    stop();
+}
+
+bool ESPEasyCfgDNSServer::start(const IPAddress& ip)
+{
+    stop();
+    //Answer record : pointer to name in question, type A, class IN, TTL and address
+    const uint8_t answer[sizeof(_answer)] = {0xC0, DNS_HEADER_SIZE, 0, DNS_TYPE_A, 0, DNS_CLASS_IN,
+                        (ESPEASYCFG_DNS_TTL >> 24) & 0xFF, (ESPEASYCFG_DNS_TTL >> 16) & 0xFF,
+                        (ESPEASYCFG_DNS_TTL >> 8) & 0xFF, ESPEASYCFG_DNS_TTL & 0xFF,
+                        0, 4, ip[0], ip[1], ip[2], ip[3]};
+    memcpy(_answer, answer, sizeof(_answer));
+#ifdef ESP32
+    if(!_udp.listen(DNS_PORT)){
+        return false;
+    }
+    _udp.onPacket([this](AsyncUDPPacket& packet){
+        uint8_t buffer[ESPEASYCFG_DNS_MAX_SIZE];
+        size_t len = (packet.length() < sizeof(buffer)) ? packet.length() : sizeof(buffer);
+        memcpy(buffer, packet.data(), len);
+        len = buildReply(buffer, len);
+        if(len > 0){
+            packet.write(buffer, len);
+        }
+    });
+    return true;
+#else
+    _pcb = udp_new();
+    if(_pcb == nullptr){
+        return false;
+    }
+    if(udp_bind(_pcb, IP_ADDR_ANY, DNS_PORT) != ERR_OK){
+        udp_remove(_pcb);
+        _pcb = nullptr;
+        return false;
+    }
+    udp_recv(_pcb, &ESPEasyCfgDNSServer::onPacket, this);
+    return true;
+#endif
+}
+
+void ESPEasyCfgDNSServer::stop()
+{
+#ifdef ESP32
+    _udp.close();
+#else
+    if(_pcb != nullptr){
+        udp_remove(_pcb);
+        _pcb = nullptr;
+    }
+#endif
+}
+
+#ifndef ESP32
+void ESPEasyCfgDNSServer::onPacket(void* arg, udp_pcb* pcb, pbuf* p, const ip_addr_t* addr, u16_t port)
+{
+    ESPEasyCfgDNSServer* server = reinterpret_cast<ESPEasyCfgDNSServer*>(arg);
+    uint8_t buffer[ESPEASYCFG_DNS_MAX_SIZE];
+    size_t len = pbuf_copy_partial(p, buffer, sizeof(buffer), 0);
+    pbuf_free(p);
+    len = server->buildReply(buffer, len);
+    if(len == 0){
+        return;
+    }
+    pbuf* out = pbuf_alloc(PBUF_TRANSPORT, len, PBUF_RAM);
+    if(out != nullptr){
+        memcpy(out->payload, buffer, len);
+        udp_sendto(pcb, out, addr, port);
+        pbuf_free(out);
+    }
+}
+#endif
+
+size_t ESPEasyCfgDNSServer::buildReply(uint8_t* packet, size_t len) const
+{
+    //Only standard queries with one question
+    if((len < DNS_HEADER_SIZE) || (packet[2] & 0x80) || (packet[2] & 0x78) ||
+        (packet[4] != 0) || (packet[5] != 1)){
+        return 0;
+    }
+    //Skip name labels
+    size_t pos = DNS_HEADER_SIZE;
+    while((pos < len) && (packet[pos] != 0)){
+        if(packet[pos] & 0xC0){
+            //No compression expected in question
+            return 0;
+        }
+        pos += packet[pos] + 1;
+    }
+    //End of name, type and class
+    pos += 5;
+    if(pos > len){
+        return 0;
+    }
+    uint16_t type = (packet[pos-4] << 8) | packet[pos-3];
+    bool answer = ((type == DNS_TYPE_A) || (type == DNS_TYPE_ANY)) && ((pos + sizeof(_answer)) <= ESPEASYCFG_DNS_MAX_SIZE);
+    //Header and question are kept, additional records are dropped
+    packet[2] = 0x84 | (packet[2] & 0x01);  //Response, authoritative, recursion desired copied
+    packet[3] = 0x00;                       //No error (other types get an empty answer)
+    packet[6] = 0;
+    packet[7] = answer ? 1 : 0;
+    memset(packet + 8, 0, 4);
+    if(answer){
+        memcpy(packet + pos, _answer, sizeof(_answer));
+        pos += sizeof(_answer);
+    }
+    return pos;
+}
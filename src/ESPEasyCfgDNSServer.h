@@ -0,0 +1,64 @@
+#ifndef _ESPEASYCFG_DNSSERVER_H_
+#define _ESPEASYCFG_DNSSERVER_H_
+
+#include <Arduino.h>
+#include <IPAddress.h>
+#ifdef ESP32
+#include <AsyncUDP.h>
+#else
+#include <lwip/udp.h>
+#endif
+
+//Time to live of answers in seconds
+#define ESPEASYCFG_DNS_TTL 60
+//Maximum size of a DNS message over UDP
+#define ESPEASYCFG_DNS_MAX_SIZE 512
+
+/**
+ * Captive portal DNS server
+ * Answers all A queries with the portal IP address. Queries are handled
+ * as packets arrive (from the network stack callback), no polling needed.
+ */
+class ESPEasyCfgDNSServer
+{
+private:
+#ifdef ESP32
+    AsyncUDP _udp;                                  //!< UDP socket
+#else
+    udp_pcb* _pcb;                                  //!< lwIP UDP control block
+#endif
+    uint8_t _answer[16];                            //!< Precomputed answer record
+
+    /**
+     * Transforms a query into its response
+     * @param packet Received packet, of ESPEASYCFG_DNS_MAX_SIZE bytes
+     * @param len Length of the received packet
+     * @return Length of the response, 0 if the query must be ignored
+     */
+    size_t buildReply(uint8_t* packet, size_t len) const;
+
+#ifndef ESP32
+    /**
+     * lwIP receive callback
+     */
+    static void onPacket(void* arg, udp_pcb* pcb, pbuf* p, const ip_addr_t* addr, u16_t port);
+#endif
+
+public:
+    ESPEasyCfgDNSServer();
+    virtual ~ESPEasyCfgDNSServer();
+
+    /**
+     * Starts answering queries
+     * @param ip IP address given in answers
+     * @return True on success
+     */
+    bool start(const IPAddress& ip);
+
+    /**
+     * Stops the server
+     */
+    void stop();
+};
+
+#endif
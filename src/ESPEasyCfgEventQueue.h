@@ -0,0 +1,101 @@
+#ifndef _ESPEASYCFG_EVENTQUEUE_H_
+#define _ESPEASYCFG_EVENTQUEUE_H_
+
+#include <Arduino.h>
+#include <atomic>
+
+/**
+ * Bounded lock-free queue
+ * Any number of tasks can push and pop at the same time, without locking.
+ * Each slot holds a sequence number telling if it is free or filled for a
+ * given round, so producers and consumers only race on the positions.
+ * A push never blocks : if the queue is full, the item is dropped and counted.
+ * @param T Type of queued items (copied)
+ * @param SIZE Number of slots, must be a power of 2
+ */
+template<typename T, size_t SIZE>
+class ESPEasyCfgEventQueue
+{
+    static_assert((SIZE >= 2) && ((SIZE & (SIZE - 1)) == 0), "Queue size must be a power of 2");
+private:
+    struct Slot {
+        std::atomic<uint32_t> sequence;     //!< Position this slot is ready for
+        T item;                             //!< Queued item
+    };
+    Slot _slots[SIZE];                      //!< Ring of slots
+    std::atomic<uint32_t> _pushPos;         //!< Next position to push to
+    std::atomic<uint32_t> _popPos;          //!< Next position to pop from
+    std::atomic<uint32_t> _dropped;         //!< Number of items dropped because the queue was full
+
+public:
+    ESPEasyCfgEventQueue() : _pushPos(0), _popPos(0), _dropped(0) {
+        for(size_t i=0;i<SIZE;++i){
+            _slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Pushes an item
+     * @param item Item to be copied to the queue
+     * @return False if the queue is full (item is dropped)
+     */
+    bool push(const T& item) {
+        uint32_t pos = _pushPos.load(std::memory_order_relaxed);
+        Slot* slot;
+        while(true){
+            slot = &_slots[pos & (SIZE - 1)];
+            int32_t diff = (int32_t)(slot->sequence.load(std::memory_order_acquire) - pos);
+            if(diff == 0){
+                //Slot is free for this round, try to claim it
+                if(_pushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)){
+                    break;
+                }
+            }else if(diff < 0){
+                //Slot still holds the item of the previous round : full
+                _dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }else{
+                //Another producer claimed this position
+                pos = _pushPos.load(std::memory_order_relaxed);
+            }
+        }
+        slot->item = item;
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Pops the oldest item
+     * @param item Destination of the item
+     * @return False if the queue is empty
+     */
+    bool pop(T& item) {
+        uint32_t pos = _popPos.load(std::memory_order_relaxed);
+        Slot* slot;
+        while(true){
+            slot = &_slots[pos & (SIZE - 1)];
+            int32_t diff = (int32_t)(slot->sequence.load(std::memory_order_acquire) - (pos + 1));
+            if(diff == 0){
+                if(_popPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)){
+                    break;
+                }
+            }else if(diff < 0){
+                //Slot not filled yet : empty
+                return false;
+            }else{
+                pos = _popPos.load(std::memory_order_relaxed);
+            }
+        }
+        item = slot->item;
+        //Free the slot for the next round
+        slot->sequence.store(pos + SIZE, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Gets the number of items dropped since creation
+     */
+    inline uint32_t getDropped() const { return _dropped.load(std::memory_order_relaxed); }
+};
+
+#endif
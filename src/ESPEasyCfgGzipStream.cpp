@@ -0,0 +1,217 @@
+#include "ESPEasyCfgGzipStream.h"
+
+#define MIN_MATCH 3
+#define MAX_MATCH 258
+
+//Base length of length codes 257 to 285
+static const uint16_t lengthBase[29] = {3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,
+                                        35,43,51,59,67,83,99,115,131,163,195,227,258};
+//Extra bits of length codes 257 to 285
+static const uint8_t lengthExtra[29] = {0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,
+                                        3,3,3,3,4,4,4,4,5,5,5,5,0};
+//Base distance of distance codes 0 to 29
+static const uint16_t distBase[30] = {1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,
+                                      257,385,513,769,1025,1537,2049,3073,4097,6145,8193,12289,16385,24577};
+//Extra bits of distance codes 0 to 29
+static const uint8_t distExtra[30] = {0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,
+                                      7,7,8,8,9,9,10,10,11,11,12,12,13,13};
+//CRC32 lookup table (4 bits at a time)
+static const uint32_t crcTable[16] = {0x00000000,0x1DB71064,0x3B6E20C8,0x26D930AC,0x76DC4190,0x6B6B51F4,0x4DB26158,0x5005713C,
+                                      0xEDB88320,0xF00F9344,0xD6D6A3E8,0xCB61B38C,0x9B64C2B0,0x86D3D2D4,0xA00AE278,0xBDBDF21C};
+
+ESPEasyCfgGzipStream::ESPEasyCfgGzipStream(Print& out) :
+    _out(out), _len(0), _pos(0), _bitBuf(0), _bitCount(0), _outLen(0),
+    _crc(0xFFFFFFFF), _size(0), _finished(false)
+{
+    memset(_head, 0, sizeof(_head));
+    //gzip header : magic, deflate, no flags, no time, unknown OS
+    static const uint8_t header[10] = {0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff};
+    for(size_t i=0;i<sizeof(header);++i){
+        putByte(header[i]);
+    }
+    //Start a fixed Huffman block (not final)
+    putBits(0, 1);
+    putBits(1, 2);
+}
+
+ESPEasyCfgGzipStream::~ESPEasyCfgGzipStream()
+{
+    finish();
+}
+
+size_t ESPEasyCfgGzipStream::write(uint8_t c)
+{
+    return write(&c, 1);
+}
+
+size_t ESPEasyCfgGzipStream::write(const uint8_t *buffer, size_t size)
+{
+    if(_finished){
+        return 0;
+    }
+    for(size_t i=0;i<size;++i){
+        _crc ^= buffer[i];
+        _crc = (_crc >> 4) ^ crcTable[_crc & 0x0F];
+        _crc = (_crc >> 4) ^ crcTable[_crc & 0x0F];
+    }
+    _size += size;
+    size_t done = 0;
+    while(done < size){
+        if(_len == sizeof(_buf)){
+            //Buffer full, encode keeping enough lookahead for matches
+            compress(_len - MAX_MATCH);
+            //Slide the window, keeping history
+            size_t shift = _pos - ESPEASYCFG_DEFLATE_WINDOW;
+            memmove(_buf, _buf + shift, _len - shift);
+            _len -= shift;
+            _pos -= shift;
+            for(size_t i=0;i<ESPEASYCFG_DEFLATE_HASH_SIZE;++i){
+                _head[i] = (_head[i] > shift) ? _head[i] - shift : 0;
+            }
+        }
+        size_t n = sizeof(_buf) - _len;
+        if(n > (size - done)){
+            n = size - done;
+        }
+        memcpy(_buf + _len, buffer + done, n);
+        _len += n;
+        done += n;
+    }
+    return size;
+}
+
+void ESPEasyCfgGzipStream::finish()
+{
+    if(_finished){
+        return;
+    }
+    compress(_len);
+    //End of block, then an empty final block
+    putSymbol(256);
+    putBits(1, 1);
+    putBits(1, 2);
+    putSymbol(256);
+    if(_bitCount > 0){
+        putBits(0, 8 - _bitCount);
+    }
+    //gzip trailer : CRC32 and size, little endian
+    uint32_t crc = ~_crc;
+    for(uint8_t i=0;i<4;++i){
+        putByte((crc >> (8*i)) & 0xFF);
+    }
+    for(uint8_t i=0;i<4;++i){
+        putByte((_size >> (8*i)) & 0xFF);
+    }
+    flushOutput();
+    _finished = true;
+}
+
+void ESPEasyCfgGzipStream::compress(size_t end)
+{
+    while(_pos < end){
+        size_t bestLen = 0;
+        size_t bestDist = 0;
+        if((_pos + MIN_MATCH) <= _len){
+            uint16_t h = hash(_pos);
+            size_t candidate = _head[h];
+            _head[h] = _pos + 1;
+            if(candidate != 0){
+                candidate -= 1;
+                size_t dist = _pos - candidate;
+                if(dist <= ESPEASYCFG_DEFLATE_WINDOW){
+                    size_t maxLen = _len - _pos;
+                    if(maxLen > MAX_MATCH){
+                        maxLen = MAX_MATCH;
+                    }
+                    size_t l = 0;
+                    while((l < maxLen) && (_buf[candidate + l] == _buf[_pos + l])){
+                        ++l;
+                    }
+                    if(l >= MIN_MATCH){
+                        bestLen = l;
+                        bestDist = dist;
+                    }
+                }
+            }
+        }
+        if(bestLen > 0){
+            putMatch(bestLen, bestDist);
+            //Index positions covered by the match
+            for(size_t i=1;i<bestLen;++i){
+                if((_pos + i + MIN_MATCH) <= _len){
+                    _head[hash(_pos + i)] = _pos + i + 1;
+                }
+            }
+            _pos += bestLen;
+        }else{
+            putSymbol(_buf[_pos]);
+            ++_pos;
+        }
+    }
+}
+
+void ESPEasyCfgGzipStream::putBits(uint32_t bits, uint8_t count)
+{
+    _bitBuf |= bits << _bitCount;
+    _bitCount += count;
+    while(_bitCount >= 8){
+        putByte(_bitBuf & 0xFF);
+        _bitBuf >>= 8;
+        _bitCount -= 8;
+    }
+}
+
+void ESPEasyCfgGzipStream::putCode(uint32_t code, uint8_t count)
+{
+    //Huffman codes are packed starting with their most significant bit
+    uint32_t reversed = 0;
+    for(uint8_t i=0;i<count;++i){
+        reversed = (reversed << 1) | ((code >> i) & 1);
+    }
+    putBits(reversed, count);
+}
+
+void ESPEasyCfgGzipStream::putSymbol(uint16_t symbol)
+{
+    if(symbol < 144){
+        putCode(0x30 + symbol, 8);
+    }else if(symbol < 256){
+        putCode(0x190 + symbol - 144, 9);
+    }else if(symbol < 280){
+        putCode(symbol - 256, 7);
+    }else{
+        putCode(0xC0 + symbol - 280, 8);
+    }
+}
+
+void ESPEasyCfgGzipStream::putMatch(uint16_t length, uint16_t distance)
+{
+    uint8_t code = 28;
+    while(lengthBase[code] > length){
+        --code;
+    }
+    putSymbol(257 + code);
+    putBits(length - lengthBase[code], lengthExtra[code]);
+    code = 29;
+    while(distBase[code] > distance){
+        --code;
+    }
+    putCode(code, 5);
+    putBits(distance - distBase[code], distExtra[code]);
+}
+
+void ESPEasyCfgGzipStream::putByte(uint8_t b)
+{
+    _outBuf[_outLen++] = b;
+    if(_outLen == sizeof(_outBuf)){
+        flushOutput();
+    }
+}
+
+void ESPEasyCfgGzipStream::flushOutput()
+{
+    if(_outLen > 0){
+        _out.write(_outBuf, _outLen);
+        _outLen = 0;
+    }
+}
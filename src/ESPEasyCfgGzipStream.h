@@ -0,0 +1,98 @@
+#ifndef _ESPEASYCFG_GZIPSTREAM_H_
+#define _ESPEASYCFG_GZIPSTREAM_H_
+
+#include <Arduino.h>
+
+//Size of the LZ77 sliding window (history kept to find matches)
+#ifndef ESPEASYCFG_DEFLATE_WINDOW
+#define ESPEASYCFG_DEFLATE_WINDOW 1024
+#endif
+
+//Number of entries of the match finder hash table
+#define ESPEASYCFG_DEFLATE_HASH_SIZE 512
+
+/**
+ * Streaming gzip compressor
+ * Data written to this stream is compressed using deflate with fixed
+ * Huffman codes and a small window, then written to the output stream.
+ * Memory usage is about 2 * ESPEASYCFG_DEFLATE_WINDOW + 1KB.
+ */
+class ESPEasyCfgGzipStream : public Print
+{
+private:
+    Print& _out;                                            //!< Output stream
+    uint8_t _buf[2 * ESPEASYCFG_DEFLATE_WINDOW];            //!< History and lookahead buffer
+    uint16_t _head[ESPEASYCFG_DEFLATE_HASH_SIZE];           //!< Last position+1 of each hash (0 if none)
+    size_t _len;                                            //!< Number of bytes in _buf
+    size_t _pos;                                            //!< Next position to be encoded
+    uint32_t _bitBuf;                                       //!< Pending output bits
+    uint8_t _bitCount;                                      //!< Number of pending output bits
+    uint8_t _outBuf[64];                                    //!< Output bytes not yet written
+    size_t _outLen;                                         //!< Number of bytes in _outBuf
+    uint32_t _crc;                                          //!< CRC32 of uncompressed data
+    uint32_t _size;                                         //!< Size of uncompressed data
+    bool _finished;                                         //!< True when trailer is written
+
+    /**
+     * Encode buffered data
+     * @param end Position where to stop encoding
+     */
+    void compress(size_t end);
+
+    /**
+     * Writes bits, LSB first
+     */
+    void putBits(uint32_t bits, uint8_t count);
+
+    /**
+     * Writes a Huffman code (MSB first)
+     */
+    void putCode(uint32_t code, uint8_t count);
+
+    /**
+     * Writes a literal/length symbol using fixed Huffman code
+     */
+    void putSymbol(uint16_t symbol);
+
+    /**
+     * Writes a match
+     * @param length Length of the match (3 to 258)
+     * @param distance Distance of the match (1 to window size)
+     */
+    void putMatch(uint16_t length, uint16_t distance);
+
+    /**
+     * Writes a byte to output
+     */
+    void putByte(uint8_t b);
+
+    /**
+     * Flush output buffer to output stream
+     */
+    void flushOutput();
+
+    /**
+     * Computes hash of 3 bytes at position
+     */
+    inline uint16_t hash(size_t pos) const {
+        return ((_buf[pos] << 6) ^ (_buf[pos+1] << 3) ^ _buf[pos+2]) & (ESPEASYCFG_DEFLATE_HASH_SIZE - 1);
+    }
+
+public:
+    /**
+     * Constructor
+     * @param out Stream to write compressed data to
+     */
+    ESPEasyCfgGzipStream(Print& out);
+    virtual ~ESPEasyCfgGzipStream();
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+
+    /**
+     * Compress remaining data and writes the gzip trailer
+     * No more data can be written after this call
+     */
+    void finish();
+};
+
+#endif
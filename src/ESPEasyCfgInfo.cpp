@@ -0,0 +1,30 @@
+#include "ESPEasyCfgInfo.h"
+
+ESPEasyCfgInfo::ESPEasyCfgInfo(const char* name, InfoProviderFunction provider,
+                                ESPEasyCfgInfoRefresh refresh, unsigned long ttl) :
+    _name(name), _provider(provider), _refresh(refresh), _ttl(ttl), _valid(false),
+    _stateGeneration(0), _lastUpdate(0), _next(nullptr)
+{
+    _value[0] = '\0';
+}
+
+const char* ESPEasyCfgInfo::getValue(uint32_t stateGeneration)
+{
+    unsigned long now = millis();
+    bool refresh = !_valid;
+    if(_refresh == ESPEasyCfgInfoRefresh::OnStateChange){
+        refresh |= (stateGeneration != _stateGeneration);
+    }else if(_refresh == ESPEasyCfgInfoRefresh::TTL){
+        refresh |= ((now - _lastUpdate) >= _ttl);
+    }
+    if(refresh){
+        _value[0] = '\0';
+        if(_provider){
+            _provider(_value, sizeof(_value));
+        }
+        _valid = true;
+        _stateGeneration = stateGeneration;
+        _lastUpdate = now;
+    }
+    return _value;
+}
@@ -0,0 +1,72 @@
+#ifndef _ESPEASYCFG_INFO_H_
+#define _ESPEASYCFG_INFO_H_
+
+#include <Arduino.h>
+#include <functional>
+
+//Size of the buffer holding the value of an information
+#ifndef ESPEASYCFG_INFO_SIZE
+#define ESPEASYCFG_INFO_SIZE 32
+#endif
+
+/**
+ * Function formatting the value of an information
+ * @param value Buffer to write the value to (empty string on call)
+ * @param size Size of the buffer
+ */
+typedef std::function<void(char* value, size_t size)> InfoProviderFunction;
+
+/**
+ * When the value of an information is computed again
+ * @Static Computed once (MAC address, firmware version)
+ * @OnStateChange Computed when the portal state changes (IP addresses)
+ * @TTL Computed when older than its time to live (RSSI, uptime)
+ */
+enum class ESPEasyCfgInfoRefresh {Static, OnStateChange, TTL};
+
+/**
+ * Device information shown on the configuration page
+ * The value is cached in a fixed buffer and only computed again according
+ * to the refresh policy, so serving the page does not allocate for it.
+ */
+class ESPEasyCfgInfo
+{
+private:
+    const char* _name;                          //!< Name of the information
+    InfoProviderFunction _provider;             //!< Function formatting the value
+    ESPEasyCfgInfoRefresh _refresh;             //!< Refresh policy
+    unsigned long _ttl;                         //!< Time to live in ms (TTL policy)
+    char _value[ESPEASYCFG_INFO_SIZE];          //!< Cached value
+    bool _valid;                                //!< True if _value is computed
+    uint32_t _stateGeneration;                  //!< State generation when computed
+    unsigned long _lastUpdate;                  //!< millis() when computed
+    ESPEasyCfgInfo* _next;                      //!< Next information of the list
+    friend class ESPEasyCfg;
+
+public:
+    /**
+     * Constructor
+     * @param name Name of the information (not copied)
+     * @param provider Function formatting the value
+     * @param refresh Refresh policy
+     * @param ttl Time to live in ms, for the TTL policy
+     */
+    ESPEasyCfgInfo(const char* name, InfoProviderFunction provider,
+                    ESPEasyCfgInfoRefresh refresh = ESPEasyCfgInfoRefresh::Static, unsigned long ttl = 0);
+
+    /**
+     * Gets the value, computing it again if needed
+     * @param stateGeneration Actual generation of the portal state
+     */
+    const char* getValue(uint32_t stateGeneration);
+
+    /**
+     * Forces the value to be computed on next use
+     */
+    inline void invalidate() { _valid = false; }
+
+    inline const char* getName() const { return _name; }
+    inline ESPEasyCfgInfo* getNext() { return _next; }
+};
+
+#endif
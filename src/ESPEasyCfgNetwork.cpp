@@ -0,0 +1,24 @@
+#include "ESPEasyCfgNetwork.h"
+
+ESPEasyCfgNetwork::ESPEasyCfgNetwork() :
+    _grp(_grpName),
+    _ssid(_ssidId, "WiFi SSID", "", "Name of the WiFi network (blank : unused)"),
+    _pass(_passId, "WiFi password", "", "Password of WiFi network"),
+    _priority(_priorityId, "Priority", 0, "Highest priority network in range is used first")
+{
+    setIndex(1);
+    _grp.add(&_ssid);
+    _grp.add(&_pass);
+    _grp.add(&_priority);
+    _ssid.setInputType("ssid");
+    _pass.setInputType("password");
+}
+
+void ESPEasyCfgNetwork::setIndex(uint8_t index)
+{
+    //Main network is number 1, additional networks start at 2
+    snprintf(_grpName, sizeof(_grpName), "WiFi network %u", index + 1);
+    snprintf(_ssidId, sizeof(_ssidId), "_wifiSSID%u", index);
+    snprintf(_passId, sizeof(_passId), "_wifiPass%u", index);
+    snprintf(_priorityId, sizeof(_priorityId), "_wifiPriority%u", index);
+}
@@ -0,0 +1,48 @@
+#ifndef _ESPEASYCFG_NETWORK_H_
+#define _ESPEASYCFG_NETWORK_H_
+
+#include "ESPEasyCfgParameter.h"
+
+//Maximum number of known WiFi networks (including the main one)
+#ifndef ESPEASYCFG_MAX_NETWORKS
+#define ESPEASYCFG_MAX_NETWORKS 3
+#endif
+
+#if ESPEASYCFG_MAX_NETWORKS < 2
+#error ESPEASYCFG_MAX_NETWORKS must be at least 2
+#endif
+
+/**
+ * Additional WiFi network the device can connect to
+ * Parameters of the network are held in their own parameter group
+ */
+class ESPEasyCfgNetwork
+{
+private:
+    char _grpName[24];                          //!< Name of the parameter group
+    char _ssidId[16];                           //!< Identifier of SSID parameter
+    char _passId[16];                           //!< Identifier of password parameter
+    char _priorityId[20];                       //!< Identifier of priority parameter
+    ESPEasyCfgParameterGroup _grp;              //!< Group holding parameters
+    ESPEasyCfgParameter<String> _ssid;          //!< SSID of the network (blank : unused)
+    ESPEasyCfgParameter<String> _pass;          //!< Password of the network (blank : open)
+    ESPEasyCfgParameter<uint16_t> _priority;    //!< Priority of the network
+public:
+    ESPEasyCfgNetwork();
+
+    /**
+     * Sets the index of this network
+     * Must be called before parameters are loaded as it sets identifiers
+     * @param index Index of the network (1 for the first additional network)
+     */
+    void setIndex(uint8_t index);
+
+    inline ESPEasyCfgParameterGroup* getGroup() { return &_grp; }
+    inline ESPEasyCfgParameter<String>* getSSIDParameter() { return &_ssid; }
+    inline ESPEasyCfgParameter<String>* getPassParameter() { return &_pass; }
+    inline String getSSID() { return _ssid.getValue(); }
+    inline String getPass() { return _pass.getValue(); }
+    inline uint16_t getPriority() { return _priority.getValue(); }
+};
+
+#endif
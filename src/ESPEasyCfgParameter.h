@@ -10,6 +10,14 @@
 
 class ESPEasyCfgAbstractParameter;
 
+/**
+ * How a parameter is stored by the parameter manager
+ * @Persisted Stored each time it is changed
+ * @Volatile Never stored, reset to default on boot (live tuning)
+ * @OnCommit Changed live, stored on an explicit save only
+ */
+enum class ESPEasyCfgPersistence {Persisted, Volatile, OnCommit};
+
 /**
  * Group of parameters
  */
@@ -41,6 +49,9 @@ private:
     const char* _description;
     const char* _extraAttributes;
     bool _hidden;
+    ESPEasyCfgPersistence _persistence;
+    bool _committed;
+    String _committedValue;
     ESPEasyCfgAbstractParameter* _nextParam;
     friend class ESPEasyCfgParameterGroup;
 
@@ -53,13 +64,15 @@ public:
             const char* description = nullptr,
             const char* extraAttributes = nullptr) : 
             _id(id), _name(name), _description(description), _extraAttributes(extraAttributes), 
-            _hidden(false), _nextParam(nullptr){}
+            _hidden(false), _persistence(ESPEasyCfgPersistence::Persisted), _committed(false),
+            _nextParam(nullptr){}
 
     ESPEasyCfgAbstractParameter(ESPEasyCfgParameterGroup& group, const char* id, const char* name, 
             const char* description = nullptr,
             const char* extraAttributes = nullptr) : 
             _id(id), _name(name), _description(description), _extraAttributes(extraAttributes), 
-            _hidden(false), _nextParam(nullptr)
+            _hidden(false), _persistence(ESPEasyCfgPersistence::Persisted), _committed(false),
+            _nextParam(nullptr)
     {
         group.add(this);
     }           
@@ -152,6 +165,35 @@ public:
      * @return True if the parameter should be hidden from the configuration page
      */
     inline bool isHidden(){return _hidden;}
+
+    /**
+     * Sets how the parameter is stored
+     * @param persistence Persistence class of the parameter
+     */
+    inline void setPersistence(ESPEasyCfgPersistence persistence){_persistence = persistence;}
+
+    /**
+     * Gets how the parameter is stored
+     */
+    inline ESPEasyCfgPersistence getPersistence(){return _persistence;}
+
+    /**
+     * Marks the actual value as the one to be stored (OnCommit parameters)
+     */
+    inline void commit(){
+        if(_persistence == ESPEasyCfgPersistence::OnCommit){
+            _committedValue = toString();
+            _committed = true;
+        }
+    }
+
+    /**
+     * Gets the value to be stored by parameter managers
+     * @return Last committed value for OnCommit parameters, actual value otherwise
+     */
+    inline String getCommittedValue(){
+        return ((_persistence == ESPEasyCfgPersistence::OnCommit) && _committed) ? _committedValue : toString();
+    }
 };
 
 /**
@@ -369,6 +411,8 @@ public:
     virtual void init(ESPEasyCfgParameterGroup* firstGroup) = 0;
     /**
      * Save parameters into file/EEPROM or whatever
+     * Volatile parameters must be skipped, OnCommit parameters stored with
+     * their committed value (getCommittedValue())
      * @firstGroup First parameter group
      * @version Version string of parameters
      * @return true on success
@@ -377,6 +421,7 @@ public:
 
     /**
      * Load parameters from file/EEPROM or whatever
+     * Volatile parameters must keep their default value
      * @firstGroup First parameter group
      * @version Version string of parameters
      * @return true on success
@@ -41,8 +41,15 @@ bool ESPEasyCfgParameterManagerJSON::saveParameters(ESPEasyCfgParameterGroup* fi
     while(grp){
         ESPEasyCfgAbstractParameter* param = grp->getFirst();
         while(param){
-            JsonObject p = arr.add<JsonObject>();
-            param->toJSON(p, true);
+            ESPEasyCfgPersistence persistence = param->getPersistence();
+            if(persistence != ESPEasyCfgPersistence::Volatile){
+                JsonObject p = arr.add<JsonObject>();
+                param->toJSON(p, true);
+                if(persistence == ESPEasyCfgPersistence::OnCommit){
+                    //Live value may not be committed yet
+                    p["value"] = param->getCommittedValue();
+                }
+            }
             param = param->getNextParameter();
         }
         grp = grp->getNext();
@@ -77,7 +84,7 @@ bool ESPEasyCfgParameterManagerJSON::loadParameters(ESPEasyCfgParameterGroup* fi
                         ESPEasyCfgAbstractParameter* param = grp->getFirst();
                         while(param){
                             JsonVariant ob = locateByID(arr, param->getIdentifier());
-                            if(!ob.isNull()){
+                            if(!ob.isNull() && (param->getPersistence() != ESPEasyCfgPersistence::Volatile)){
                                 DebugPrint("Loading ");
                                 DebugPrint(param->getIdentifier());
                                 String s;
@@ -0,0 +1,154 @@
+#include "ESPEasyCfgScanService.h"
+#include <limits.h>
+
+//Default time spent on each channel (ESP32)
+#define DEFAULT_DWELL_TIME 300
+
+#ifdef ESP32
+#include <WiFi.h>
+//Results are imported by the state machine task and read by the web server task
+static portMUX_TYPE scanMux = portMUX_INITIALIZER_UNLOCKED;
+#define SCAN_LOCK() portENTER_CRITICAL(&scanMux)
+#define SCAN_UNLOCK() portEXIT_CRITICAL(&scanMux)
+#else
+#include <ESP8266WiFi.h>
+#define WIFI_AUTH_OPEN ENC_TYPE_NONE
+#define SCAN_LOCK()
+#define SCAN_UNLOCK()
+#endif
+
+ESPEasyCfgScanService::ESPEasyCfgScanService() :
+    _count(0), _filtered(false), _running(false), _runningFiltered(false),
+    _time(0), _generation(0), _scanCount(0), _failed(false), _requested(false)
+{
+}
+
+bool ESPEasyCfgScanService::start(const char* ssid, bool showHidden, uint32_t dwellTime, uint8_t channel)
+{
+    if(_running){
+        return false;
+    }
+    WiFi.scanDelete();
+#ifdef ESP8266
+    WiFi.scanNetworks(true, showHidden, channel, reinterpret_cast<uint8*>(const_cast<char*>(ssid)));
+#else
+    WiFi.scanNetworks(true, showHidden, false, (dwellTime > 0) ? dwellTime : DEFAULT_DWELL_TIME, channel, ssid);
+#endif
+    _running = true;
+    _runningFiltered = (ssid != nullptr) || (channel != 0);
+    return true;
+}
+
+bool ESPEasyCfgScanService::poll()
+{
+    if(_running){
+        int n = WiFi.scanComplete();
+        if(n == WIFI_SCAN_RUNNING){
+            return true;
+        }
+        _running = false;
+        import(n);
+    }
+    if(_requested){
+        _requested = false;
+        start();
+    }
+    return _running;
+}
+
+void ESPEasyCfgScanService::import(int n)
+{
+    if(n < 0){
+        //Failed or aborted, previous results are still the best known
+        WiFi.scanDelete();
+        SCAN_LOCK();
+        _failed = true;
+        ++_scanCount;
+        SCAN_UNLOCK();
+        return;
+    }
+    ESPEasyCfgScanResult results[ESPEASYCFG_SCAN_MAX];
+    uint8_t count = 0;
+    for(int i=0;i<n;++i){
+        String ssid = WiFi.SSID(i);
+        int32_t rssi = WiFi.RSSI(i);
+        if((ssid.length() == 0) || (ssid.length() >= sizeof(results[0].ssid))){
+            //Hidden network
+            continue;
+        }
+        //Look for this SSID (one entry per network)
+        uint8_t pos = 0;
+        while((pos < count) && (ssid != results[pos].ssid)){
+            ++pos;
+        }
+        if(pos < count){
+            if(rssi <= results[pos].rssi){
+                continue;
+            }
+            //Stronger access point, remove previous one
+            memmove(&results[pos], &results[pos+1], (count-pos-1) * sizeof(results[0]));
+            --count;
+        }
+        //Insert sorted by signal strength
+        pos = 0;
+        while((pos < count) && (results[pos].rssi >= rssi)){
+            ++pos;
+        }
+        if(pos >= ESPEASYCFG_SCAN_MAX){
+            continue;
+        }
+        if(count == ESPEASYCFG_SCAN_MAX){
+            --count;
+        }
+        memmove(&results[pos+1], &results[pos], (count-pos) * sizeof(results[0]));
+        ++count;
+        ESPEasyCfgScanResult& r = results[pos];
+        strcpy(r.ssid, ssid.c_str());
+        memcpy(r.bssid, WiFi.BSSID(i), sizeof(r.bssid));
+        r.rssi = rssi;
+        r.channel = WiFi.channel(i);
+        r.open = (WiFi.encryptionType(i) == WIFI_AUTH_OPEN);
+    }
+    WiFi.scanDelete();
+    SCAN_LOCK();
+    memcpy(_results, results, count * sizeof(results[0]));
+    _count = count;
+    _filtered = _runningFiltered;
+    _time = millis();
+    if(++_generation == 0){
+        _generation = 1;
+    }
+    _failed = false;
+    ++_scanCount;
+    SCAN_UNLOCK();
+}
+
+unsigned long ESPEasyCfgScanService::getAge() const
+{
+    if(_generation == 0){
+        return ULONG_MAX;
+    }
+    return millis() - _time;
+}
+
+const ESPEasyCfgScanResult* ESPEasyCfgScanService::find(const String& ssid) const
+{
+    for(uint8_t i=0;i<_count;++i){
+        if(ssid == _results[i].ssid){
+            return &_results[i];
+        }
+    }
+    return nullptr;
+}
+
+uint8_t ESPEasyCfgScanService::snapshot(ESPEasyCfgScanResult* dest, uint32_t& generation, unsigned long& age)
+{
+    SCAN_LOCK();
+    uint8_t count = _count;
+    memcpy(dest, _results, count * sizeof(_results[0]));
+    generation = _generation;
+    unsigned long time = _time;
+    SCAN_UNLOCK();
+    age = (generation == 0) ? ULONG_MAX : (millis() - time);
+    return count;
+}
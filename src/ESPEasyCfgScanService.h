@@ -0,0 +1,106 @@
+#ifndef _ESPEASYCFG_SCANSERVICE_H_
+#define _ESPEASYCFG_SCANSERVICE_H_
+
+#include <Arduino.h>
+
+//Maximum number of networks kept from a scan
+#ifndef ESPEASYCFG_SCAN_MAX
+#define ESPEASYCFG_SCAN_MAX 16
+#endif
+
+/**
+ * Network found by a scan
+ */
+struct ESPEasyCfgScanResult {
+    char ssid[33];              //!< SSID of the network
+    uint8_t bssid[6];           //!< BSSID of the strongest access point
+    int8_t rssi;                //!< Signal strength of the strongest access point
+    uint8_t channel;            //!< Channel of the strongest access point
+    bool open;                  //!< True if the network is not encrypted
+};
+
+/**
+ * WiFi scan service
+ * Owns scan scheduling and keeps the last results, one entry per SSID
+ * (strongest access point) sorted by signal strength. Scans are started
+ * and results imported from the state machine only; other tasks request
+ * scans with request() and read results with snapshot().
+ */
+class ESPEasyCfgScanService
+{
+private:
+    ESPEasyCfgScanResult _results[ESPEASYCFG_SCAN_MAX];    //!< Last results, strongest first
+    uint8_t _count;                                         //!< Number of results
+    bool _filtered;                                         //!< True if last results are for one SSID or one channel only
+    bool _running;                                          //!< True if a scan is running
+    bool _runningFiltered;                                  //!< True if the running scan is for one SSID or one channel only
+    unsigned long _time;                                    //!< millis() of last results
+    uint32_t _generation;                                   //!< Incremented on each new results (0 : none)
+    uint32_t _scanCount;                                    //!< Incremented on each finished scan, failed or not
+    bool _failed;                                           //!< True if the last scan failed, results are older
+    volatile bool _requested;                               //!< A full scan is requested
+
+    /**
+     * Imports driver results and frees them
+     * A failed scan keeps the previous results and generation
+     * @param n Number of networks found by the driver, negative if the scan failed
+     */
+    void import(int n);
+
+public:
+    ESPEasyCfgScanService();
+
+    /**
+     * Starts a scan now (state machine only)
+     * @param ssid SSID to look for, nullptr for all networks
+     * @param showHidden True to include hidden networks
+     * @param dwellTime Time spent on each channel in ms (0 : default, ESP32 only)
+     * @param channel Channel to scan, 0 for all channels
+     * @return True if started, false if a scan is already running
+     */
+    bool start(const char* ssid = nullptr, bool showHidden = false, uint32_t dwellTime = 0, uint8_t channel = 0);
+
+    /**
+     * Starts requested scans and imports results (state machine only)
+     * @return True if a scan is running
+     */
+    bool poll();
+
+    /**
+     * Requests a full scan (thread safe)
+     * It is started at next poll() if no scan is running.
+     */
+    inline void request() { _requested = true; }
+
+    inline bool isRunning() const { return _running || _requested; }
+    inline bool isFiltered() const { return _filtered; }
+    inline uint32_t getGeneration() const { return _generation; }
+    inline uint32_t getScanCount() const { return _scanCount; }
+    inline bool hasFailed() const { return _failed; }
+    inline uint8_t getCount() const { return _count; }
+    inline const ESPEasyCfgScanResult& get(uint8_t i) const { return _results[i]; }
+
+    /**
+     * Gets age of results
+     * @return Age in ms, ULONG_MAX if there is no result
+     */
+    unsigned long getAge() const;
+
+    /**
+     * Finds a network in results
+     * @param ssid SSID of the network
+     * @return Result or nullptr if not found
+     */
+    const ESPEasyCfgScanResult* find(const String& ssid) const;
+
+    /**
+     * Copies results (thread safe)
+     * @param dest Array of ESPEASYCFG_SCAN_MAX entries
+     * @param generation Generation of the results
+     * @param age Age of the results in ms
+     * @return Number of results copied
+     */
+    uint8_t snapshot(ESPEasyCfgScanResult* dest, uint32_t& generation, unsigned long& age);
+};
+
+#endif
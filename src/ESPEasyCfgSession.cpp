@@ -0,0 +1,202 @@
+#include "ESPEasyCfgSession.h"
+#ifdef ESP32
+#if __has_include(<esp_random.h>)
+#include <esp_random.h>
+#else
+#include <esp_system.h>
+#endif
+#endif
+
+#define SESSION_TIMEOUT 3600
+#define KEY_SIZE 32
+#define BLOCK_SIZE 64
+#define MAC_SIZE 16
+
+static const char hex_digits[] = "0123456789abcdef";
+
+static void shaStart(ESPEasyCfgSHA256Context* ctx)
+{
+#ifdef ESP32
+    mbedtls_sha256_init(ctx);
+    mbedtls_sha256_starts(ctx, 0);
+#else
+    br_sha256_init(ctx);
+#endif
+}
+
+static void shaCopy(ESPEasyCfgSHA256Context* dst, const ESPEasyCfgSHA256Context* src)
+{
+#ifdef ESP32
+    mbedtls_sha256_init(dst);
+    mbedtls_sha256_clone(dst, src);
+#else
+    *dst = *src;
+#endif
+}
+
+static void shaUpdate(ESPEasyCfgSHA256Context* ctx, const uint8_t* data, size_t len)
+{
+#ifdef ESP32
+    mbedtls_sha256_update(ctx, data, len);
+#else
+    br_sha256_update(ctx, data, len);
+#endif
+}
+
+static void shaFinish(ESPEasyCfgSHA256Context* ctx, uint8_t* digest)
+{
+#ifdef ESP32
+    mbedtls_sha256_finish(ctx, digest);
+    mbedtls_sha256_free(ctx);
+#else
+    br_sha256_out(ctx, digest);
+#endif
+}
+
+static int8_t hexValue(char c)
+{
+    if((c >= '0') && (c <= '9')){
+        return c - '0';
+    }
+    if((c >= 'a') && (c <= 'f')){
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+ESPEasyCfgSession::ESPEasyCfgSession() :
+    _keyed(false), _timeout(SESSION_TIMEOUT)
+{
+#ifdef ESP32
+    mbedtls_sha256_init(&_inner);
+    mbedtls_sha256_init(&_outer);
+#endif
+}
+
+ESPEasyCfgSession::~ESPEasyCfgSession()
+{
+#ifdef ESP32
+    mbedtls_sha256_free(&_inner);
+    mbedtls_sha256_free(&_outer);
+#endif
+}
+
+void ESPEasyCfgSession::renew()
+{
+    uint8_t key[BLOCK_SIZE];
+    uint8_t pad[BLOCK_SIZE];
+    memset(key, 0, sizeof(key));
+#ifdef ESP32
+    esp_fill_random(key, KEY_SIZE);
+    mbedtls_sha256_free(&_inner);
+    mbedtls_sha256_free(&_outer);
+#else
+    ESP.random(key, KEY_SIZE);
+#endif
+    //Keyed states are computed once, each MAC then costs two blocks
+    for(uint8_t i=0;i<BLOCK_SIZE;++i){
+        pad[i] = key[i] ^ 0x36;
+    }
+    shaStart(&_inner);
+    shaUpdate(&_inner, pad, BLOCK_SIZE);
+    for(uint8_t i=0;i<BLOCK_SIZE;++i){
+        pad[i] = key[i] ^ 0x5c;
+    }
+    shaStart(&_outer);
+    shaUpdate(&_outer, pad, BLOCK_SIZE);
+    memset(key, 0, sizeof(key));
+    memset(pad, 0, sizeof(pad));
+    _keyed = true;
+}
+
+void ESPEasyCfgSession::sign(uint32_t expiry, uint8_t* mac)
+{
+    uint8_t msg[4] = {(uint8_t)(expiry >> 24), (uint8_t)(expiry >> 16), (uint8_t)(expiry >> 8), (uint8_t)expiry};
+    uint8_t digest[32];
+    ESPEasyCfgSHA256Context ctx;
+    shaCopy(&ctx, &_inner);
+    shaUpdate(&ctx, msg, sizeof(msg));
+    shaFinish(&ctx, digest);
+    shaCopy(&ctx, &_outer);
+    shaUpdate(&ctx, digest, sizeof(digest));
+    shaFinish(&ctx, digest);
+    memcpy(mac, digest, MAC_SIZE);
+}
+
+void ESPEasyCfgSession::createToken(char* token)
+{
+    uint32_t expiry = (millis() / 1000) + _timeout;
+    uint8_t mac[MAC_SIZE];
+    sign(expiry, mac);
+    for(uint8_t i=0;i<8;++i){
+        token[i] = hex_digits[(expiry >> (28 - 4*i)) & 0x0F];
+    }
+    for(uint8_t i=0;i<MAC_SIZE;++i){
+        token[8 + 2*i] = hex_digits[mac[i] >> 4];
+        token[9 + 2*i] = hex_digits[mac[i] & 0x0F];
+    }
+    token[ESPEASYCFG_SESSION_TOKEN_LEN] = '\0';
+}
+
+bool ESPEasyCfgSession::validate(const char* token)
+{
+    if(!_keyed){
+        return false;
+    }
+    uint8_t received[MAC_SIZE + 4];
+    for(uint8_t i=0;i<sizeof(received);++i){
+        int8_t hi = hexValue(token[2*i]);
+        int8_t lo = (hi < 0) ? -1 : hexValue(token[2*i + 1]);
+        if(lo < 0){
+            return false;
+        }
+        received[i] = (hi << 4) | lo;
+    }
+    uint32_t expiry = ((uint32_t)received[0] << 24) | ((uint32_t)received[1] << 16) |
+                        ((uint32_t)received[2] << 8) | received[3];
+    //Expired, or issued before millis() wrapped
+    int32_t left = (int32_t)(expiry - (millis() / 1000));
+    if((left <= 0) || ((uint32_t)left > _timeout)){
+        return false;
+    }
+    uint8_t mac[MAC_SIZE];
+    sign(expiry, mac);
+    uint8_t diff = 0;
+    for(uint8_t i=0;i<MAC_SIZE;++i){
+        diff |= mac[i] ^ received[4 + i];
+    }
+    return diff == 0;
+}
+
+bool ESPEasyCfgSession::validate(AsyncWebServerRequest *request)
+{
+    const AsyncWebHeader* header = request->getHeader("Cookie");
+    if(header == nullptr){
+        return false;
+    }
+    //Look for our cookie in "name1=value1; name2=value2"
+    const char* cookies = header->value().c_str();
+    const size_t nameLen = sizeof(ESPEASYCFG_SESSION_COOKIE) - 1;
+    const char* pos = cookies;
+    while((pos = strstr(pos, ESPEASYCFG_SESSION_COOKIE "=")) != nullptr){
+        if((pos == cookies) || (pos[-1] == ' ') || (pos[-1] == ';')){
+            const char* value = pos + nameLen + 1;
+            //validate() stops at the first non hex digit, so a short value is rejected
+            return validate(value);
+        }
+        pos += nameLen;
+    }
+    return false;
+}
+
+bool ESPEasyCfgSession::equals(const char* a, const char* b)
+{
+    size_t lenA = strlen(a);
+    size_t lenB = strlen(b);
+    uint8_t diff = (lenA != lenB) ? 1 : 0;
+    //Always go through b, the secret
+    for(size_t i=0;i<lenB;++i){
+        diff |= (uint8_t)(b[i] ^ a[(i < lenA) ? i : 0]);
+    }
+    return diff == 0;
+}
@@ -0,0 +1,87 @@
+#ifndef _ESPEASYCFG_SESSION_H_
+#define _ESPEASYCFG_SESSION_H_
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#ifdef ESP32
+#include <mbedtls/sha256.h>
+typedef mbedtls_sha256_context ESPEasyCfgSHA256Context;
+#elif defined(ESP8266)
+#include <bearssl/bearssl_hash.h>
+typedef br_sha256_context ESPEasyCfgSHA256Context;
+#endif
+
+//Length of a session token : expiry (8 hex digits) and truncated HMAC (32 hex digits)
+#define ESPEASYCFG_SESSION_TOKEN_LEN 40
+
+//Name of the session cookie
+#define ESPEASYCFG_SESSION_COOKIE "ESPSESSION"
+
+/**
+ * Session tokens given to authenticated clients
+ * A token holds its expiry time (uptime in s) signed with HMAC-SHA256,
+ * using a random key drawn at startup. Tokens are checked without
+ * allocation and in constant time, no state is kept per session.
+ * Renewing the key (password change) invalidates all sessions.
+ */
+class ESPEasyCfgSession
+{
+private:
+    ESPEasyCfgSHA256Context _inner;         //!< SHA-256 state after the inner padded key
+    ESPEasyCfgSHA256Context _outer;         //!< SHA-256 state after the outer padded key
+    bool _keyed;                            //!< True if a key was drawn
+    uint32_t _timeout;                      //!< Lifetime of sessions in s
+
+    /**
+     * Computes the truncated HMAC of an expiry time
+     * @param expiry Expiry time
+     * @param mac Destination of the MAC (16 bytes)
+     */
+    void sign(uint32_t expiry, uint8_t* mac);
+
+public:
+    ESPEasyCfgSession();
+    virtual ~ESPEasyCfgSession();
+
+    /**
+     * Draws a new key, invalidating all sessions
+     */
+    void renew();
+
+    /**
+     * Creates a session token
+     * @param token Destination, ESPEASYCFG_SESSION_TOKEN_LEN + 1 bytes
+     */
+    void createToken(char* token);
+
+    /**
+     * Checks a session token
+     * @param token Token (only the first ESPEASYCFG_SESSION_TOKEN_LEN characters are used)
+     * @return True if the token is authentic and not expired
+     */
+    bool validate(const char* token);
+
+    /**
+     * Checks the session cookie of a request
+     * @return True if the request holds a valid session
+     */
+    bool validate(AsyncWebServerRequest *request);
+
+    /**
+     * Compares two secrets in a time independent of their content
+     */
+    static bool equals(const char* a, const char* b);
+
+    /**
+     * Sets the lifetime of new sessions
+     * @param timeout Lifetime in s
+     */
+    inline void setTimeout(uint32_t timeout) { _timeout = timeout; }
+
+    /**
+     * Gets the lifetime of sessions in s
+     */
+    inline uint32_t getTimeout() const { return _timeout; }
+};
+
+#endif
@@ -0,0 +1,348 @@
+#include "ESPEasyCfgTransfer.h"
+
+using namespace ArduinoJson;
+
+//Appends a JSON string (quoted and escaped)
+static void appendJSONString(String& out, const char* str)
+{
+    out += '"';
+    for(const char* c = str; *c != '\0'; ++c){
+        switch(*c){
+            case '"':
+                out += "\\\"";
+                break;
+            case '\\':
+                out += "\\\\";
+                break;
+            case '\n':
+                out += "\\n";
+                break;
+            case '\r':
+                out += "\\r";
+                break;
+            case '\t':
+                out += "\\t";
+                break;
+            default:
+                if((uint8_t)*c < 0x20){
+                    char esc[8];
+                    snprintf(esc, sizeof(esc), "\\u%04x", (unsigned int)*c);
+                    out += esc;
+                }else{
+                    out += *c;
+                }
+                break;
+        }
+    }
+    out += '"';
+}
+
+ESPEasyCfgExporter::ESPEasyCfgExporter(ESPEasyCfgParameterGroup* first, const char* version, bool secrets) :
+    _version(version), _secrets(secrets), _grp(first), _param(first ? first->getFirst() : nullptr),
+    _step(0), _first(true), _pendingPos(0)
+{
+}
+
+bool ESPEasyCfgExporter::next()
+{
+    _pending = "";
+    _pendingPos = 0;
+    switch(_step){
+        case 0:
+            _pending = "{\"version\":";
+            appendJSONString(_pending, _version);
+            _pending += ",\"values\":{";
+            _step = 1;
+            return true;
+        case 1:
+            while(_grp != nullptr){
+                if(_param == nullptr){
+                    _grp = _grp->getNext();
+                    _param = (_grp != nullptr) ? _grp->getFirst() : nullptr;
+                    continue;
+                }
+                ESPEasyCfgAbstractParameter* param = _param;
+                _param = _param->getNextParameter();
+                if(param->getPersistence() == ESPEasyCfgPersistence::Volatile){
+                    continue;
+                }
+                const char* type = param->getInputType();
+                if(!_secrets && (type != nullptr) && (strcmp(type, "password") == 0)){
+                    continue;
+                }
+                if(!_first){
+                    _pending += ',';
+                }
+                _first = false;
+                appendJSONString(_pending, param->getIdentifier());
+                _pending += ':';
+                appendJSONString(_pending, param->getCommittedValue().c_str());
+                return true;
+            }
+            _pending = "}}";
+            _step = 2;
+            return true;
+        default:
+            _step = 3;
+            return false;
+    }
+}
+
+size_t ESPEasyCfgExporter::read(uint8_t* buffer, size_t maxLen)
+{
+    size_t len = 0;
+    while(len < maxLen){
+        if(_pendingPos >= _pending.length()){
+            if(!next()){
+                break;
+            }
+        }
+        size_t n = _pending.length() - _pendingPos;
+        if(n > (maxLen - len)){
+            n = maxLen - len;
+        }
+        memcpy(buffer + len, _pending.c_str() + _pendingPos, n);
+        _pendingPos += n;
+        len += n;
+    }
+    return len;
+}
+
+ESPEasyCfgImporter::ESPEasyCfgImporter(ESPEasyCfgParameterGroup* first) :
+    _first(first), _state(State::Start), _afterToken(State::Error), _escape(false),
+    _unicodeDigits(0), _unicode(0), _tokenLen(0), _tokenIsString(false), _ignored(0), _error(nullptr)
+{
+    _key[0] = '\0';
+    _token[0] = '\0';
+    _values.to<JsonObject>();
+}
+
+void ESPEasyCfgImporter::write(const uint8_t* data, size_t len)
+{
+    for(size_t i=0;(i<len) && (_state != State::Error);++i){
+        parse((char)data[i]);
+    }
+}
+
+void ESPEasyCfgImporter::fail(const char* error)
+{
+    if(_state != State::Error){
+        _error = error;
+        _state = State::Error;
+    }
+}
+
+void ESPEasyCfgImporter::append(char c)
+{
+    if(_tokenLen >= (sizeof(_token) - 1)){
+        fail("Value too long");
+        return;
+    }
+    _token[_tokenLen++] = c;
+    _token[_tokenLen] = '\0';
+}
+
+bool ESPEasyCfgImporter::isKnown(const char* id)
+{
+    for(ESPEasyCfgParameterGroup* grp = _first; grp != nullptr; grp = grp->getNext()){
+        for(ESPEasyCfgAbstractParameter* param = grp->getFirst(); param != nullptr; param = param->getNextParameter()){
+            if(strcmp(param->getIdentifier(), id) == 0){
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void ESPEasyCfgImporter::endToken()
+{
+    State after = _afterToken;
+    _state = after;
+    switch(after){
+        case State::TopColon:
+        case State::ValuesColon:
+            //Token was a key
+            if(!_tokenIsString){
+                fail("Key must be a string");
+                return;
+            }
+            strcpy(_key, _token);
+            break;
+        case State::TopNext:
+            //Value of a top level key
+            if(strcmp(_key, "version") == 0){
+                _version = _token;
+            }else if(strcmp(_key, "values") == 0){
+                fail("Values must be an object");
+            }
+            break;
+        case State::ValuesNext:
+            //Value of a parameter, null leaves it unchanged
+            if(!_tokenIsString && (strcmp(_token, "null") == 0)){
+                break;
+            }
+            if(isKnown(_key)){
+                _values[String(_key)] = String(_token);
+            }else{
+                ++_ignored;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void ESPEasyCfgImporter::parse(char c)
+{
+    bool space = (c == ' ') || (c == '\t') || (c == '\r') || (c == '\n');
+    switch(_state){
+        case State::String:
+            if(_unicodeDigits > 0){
+                int8_t v = ((c >= '0') && (c <= '9')) ? (c - '0') :
+                            ((c >= 'a') && (c <= 'f')) ? (c - 'a' + 10) :
+                            ((c >= 'A') && (c <= 'F')) ? (c - 'A' + 10) : -1;
+                if(v < 0){
+                    fail("Bad unicode escape");
+                    return;
+                }
+                _unicode = (_unicode << 4) | v;
+                if(--_unicodeDigits == 0){
+                    //Encode code point as UTF-8 (surrogates are not combined)
+                    if(_unicode < 0x80){
+                        append((char)_unicode);
+                    }else if(_unicode < 0x800){
+                        append((char)(0xC0 | (_unicode >> 6)));
+                        append((char)(0x80 | (_unicode & 0x3F)));
+                    }else{
+                        append((char)(0xE0 | (_unicode >> 12)));
+                        append((char)(0x80 | ((_unicode >> 6) & 0x3F)));
+                        append((char)(0x80 | (_unicode & 0x3F)));
+                    }
+                }
+            }else if(_escape){
+                _escape = false;
+                switch(c){
+                    case 'n': append('\n'); break;
+                    case 'r': append('\r'); break;
+                    case 't': append('\t'); break;
+                    case 'b': append('\b'); break;
+                    case 'f': append('\f'); break;
+                    case 'u':
+                        _unicodeDigits = 4;
+                        _unicode = 0;
+                        break;
+                    default: append(c); break;
+                }
+            }else if(c == '\\'){
+                _escape = true;
+            }else if(c == '"'){
+                endToken();
+            }else{
+                append(c);
+            }
+            return;
+        case State::Literal:
+            if(isalnum(c) || (c == '-') || (c == '+') || (c == '.')){
+                append(c);
+                return;
+            }
+            endToken();
+            //Delimiter belongs to the next state
+            if(_state != State::Error){
+                parse(c);
+            }
+            return;
+        default:
+            break;
+    }
+    if(space){
+        return;
+    }
+    //Starts reading a string or a literal token
+    auto startToken = [this, c](State after){
+        _afterToken = after;
+        _tokenLen = 0;
+        _token[0] = '\0';
+        _tokenIsString = (c == '"');
+        if(_tokenIsString){
+            _state = State::String;
+        }else{
+            _state = State::Literal;
+            append(c);
+        }
+    };
+    switch(_state){
+        case State::Start:
+            if(c == '{'){
+                _state = State::TopKey;
+            }else{
+                fail("Object expected");
+            }
+            break;
+        case State::TopKey:
+            if(c == '"'){
+                startToken(State::TopColon);
+            }else if(c == '}'){
+                _state = State::Done;
+            }else{
+                fail("Key expected");
+            }
+            break;
+        case State::TopColon:
+        case State::ValuesColon:
+            if(c == ':'){
+                _state = (_state == State::TopColon) ? State::TopValue : State::ValuesValue;
+            }else{
+                fail("Colon expected");
+            }
+            break;
+        case State::TopValue:
+            if((c == '{') && (strcmp(_key, "values") == 0)){
+                _state = State::ValuesKey;
+            }else if((c == '{') || (c == '[')){
+                fail("Unexpected object or array");
+            }else{
+                startToken(State::TopNext);
+            }
+            break;
+        case State::TopNext:
+            if(c == ','){
+                _state = State::TopKey;
+            }else if(c == '}'){
+                _state = State::Done;
+            }else{
+                fail("Comma expected");
+            }
+            break;
+        case State::ValuesKey:
+            if(c == '"'){
+                startToken(State::ValuesColon);
+            }else if(c == '}'){
+                _state = State::TopNext;
+            }else{
+                fail("Key expected");
+            }
+            break;
+        case State::ValuesValue:
+            if((c == '{') || (c == '[')){
+                fail("Values must be strings, numbers or booleans");
+            }else{
+                startToken(State::ValuesNext);
+            }
+            break;
+        case State::ValuesNext:
+            if(c == ','){
+                _state = State::ValuesKey;
+            }else if(c == '}'){
+                _state = State::TopNext;
+            }else{
+                fail("Comma expected");
+            }
+            break;
+        case State::Done:
+            fail("Data after document");
+            break;
+        default:
+            break;
+    }
+}
@@ -0,0 +1,156 @@
+#ifndef _ESPEASYCFG_TRANSFER_H_
+#define _ESPEASYCFG_TRANSFER_H_
+
+#include <ArduinoJson.hpp>
+#include "ESPEasyCfgParameter.h"
+
+//Maximum length of an imported identifier or value
+#ifndef ESPEASYCFG_IMPORT_VALUE_SIZE
+#define ESPEASYCFG_IMPORT_VALUE_SIZE 256
+#endif
+
+/**
+ * Writes the configuration as a JSON document, piece by piece
+ * Document is {"version":"x","values":{"id":"value",...}}, values being
+ * strings. Only one parameter is formatted at a time, so the size of the
+ * document is not bounded by the heap. As for the parameter manager,
+ * volatile parameters are left out and OnCommit ones give their committed
+ * value.
+ */
+class ESPEasyCfgExporter
+{
+private:
+    const char* _version;                       //!< Version of the configuration
+    bool _secrets;                              //!< True to export passwords
+    ESPEasyCfgParameterGroup* _grp;             //!< Group of the next parameter
+    ESPEasyCfgAbstractParameter* _param;        //!< Next parameter to be written
+    uint8_t _step;                              //!< 0 : header, 1 : parameters, 2 : trailer, 3 : done
+    bool _first;                                //!< True until a parameter is written
+    String _pending;                            //!< Formatted text not yet read
+    size_t _pendingPos;                         //!< Position of next character of _pending
+
+    /**
+     * Formats the next piece of the document into _pending
+     * @return False if the document is complete
+     */
+    bool next();
+
+public:
+    /**
+     * Constructor
+     * @param first First parameter group
+     * @param version Version of the configuration
+     * @param secrets True to export passwords
+     */
+    ESPEasyCfgExporter(ESPEasyCfgParameterGroup* first, const char* version, bool secrets);
+
+    /**
+     * Reads next bytes of the document
+     * @param buffer Destination buffer
+     * @param maxLen Size of the buffer
+     * @return Number of bytes written, 0 at the end of the document
+     */
+    size_t read(uint8_t* buffer, size_t maxLen);
+};
+
+/**
+ * Parses a configuration document written by ESPEasyCfgExporter, as it
+ * is received
+ * Values of known parameters are staged, to be applied once the whole
+ * document is parsed. Unknown identifiers are ignored, so memory use is
+ * bounded by the size of the configuration, not of the document.
+ */
+class ESPEasyCfgImporter
+{
+private:
+    /**
+     * State of the parser
+     */
+    enum class State {Start, TopKey, TopColon, TopValue, TopNext, ValuesKey, ValuesColon, ValuesValue, ValuesNext,
+                        String, Literal, Done, Error};
+
+    ESPEasyCfgParameterGroup* _first;           //!< First parameter group
+    ArduinoJson::JsonDocument _values;          //!< Staged values, by identifier
+    State _state;                               //!< Actual state
+    State _afterToken;                          //!< State once the actual string or literal is read
+    bool _escape;                               //!< True after a backslash in a string
+    uint8_t _unicodeDigits;                     //!< Number of hex digits of a \u escape left to read
+    uint16_t _unicode;                          //!< Code point of a \u escape
+    char _key[ESPEASYCFG_IMPORT_VALUE_SIZE];    //!< Last key
+    char _token[ESPEASYCFG_IMPORT_VALUE_SIZE];  //!< String or literal being read
+    size_t _tokenLen;                           //!< Length of _token
+    bool _tokenIsString;                        //!< True if _token was quoted
+    String _version;                            //!< Version of the document
+    uint16_t _ignored;                          //!< Number of unknown identifiers
+    const char* _error;                         //!< Parse error, nullptr if none
+
+    /**
+     * Processes a character
+     */
+    void parse(char c);
+
+    /**
+     * Appends a character to the token
+     */
+    void append(char c);
+
+    /**
+     * Handles a complete token
+     */
+    void endToken();
+
+    /**
+     * Stops parsing with an error
+     */
+    void fail(const char* error);
+
+    /**
+     * Checks if a parameter exists
+     */
+    bool isKnown(const char* id);
+
+public:
+    /**
+     * Constructor
+     * @param first First parameter group, to check identifiers
+     */
+    ESPEasyCfgImporter(ESPEasyCfgParameterGroup* first);
+
+    /**
+     * Parses next bytes of the document
+     */
+    void write(const uint8_t* data, size_t len);
+
+    /**
+     * Gets if the whole document was parsed without error
+     */
+    inline bool isComplete() const { return _state == State::Done; }
+
+    /**
+     * Gets the parse error
+     * @return Error message, or nullptr if none
+     */
+    inline const char* getError() const { return (_state == State::Done) ? nullptr : (_error ? _error : "Incomplete document"); }
+
+    /**
+     * Gets the version of the document
+     */
+    inline const String& getVersion() const { return _version; }
+
+    /**
+     * Gets the staged values, by identifier
+     */
+    inline ArduinoJson::JsonObject getValues() { return _values.as<ArduinoJson::JsonObject>(); }
+
+    /**
+     * Gets the number of staged values
+     */
+    inline size_t getCount() { return _values.size(); }
+
+    /**
+     * Gets the number of ignored identifiers
+     */
+    inline uint16_t getIgnored() const { return _ignored; }
+};
+
+#endif
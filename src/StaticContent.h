@@ -6,4 +6,22 @@
 
 AsyncWebHandler* registerStaticFiles(AsyncWebServer* webServer);
 
-#endif
\ No newline at end of file
+/**
+ * Checks if the client accepts an encoding (Accept-Encoding header)
+ * @param request Request to check
+ * @param encoding Encoding to look for ("identity" for no encoding)
+ * @return True if the encoding, or else *, is listed and not refused with q=0.
+ * Identity is also accepted when not listed, unless refused by *;q=0.
+ */
+bool acceptsEncoding(AsyncWebServerRequest *request, const char* encoding);
+
+/**
+ * Checks a conditional request against an entity tag (If-None-Match header)
+ * Uses the weak comparison, W/ prefixes are ignored.
+ * @param request Request to check
+ * @param etag Quoted entity tag of the actual content
+ * @return True if the client copy matches, either listed or with *
+ */
+bool matchesETag(AsyncWebServerRequest *request, const char* etag);
+
+#endif